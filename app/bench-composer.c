@@ -0,0 +1,139 @@
+#include <import>
+#include <sys/time.h>
+#include <sched.h>
+#include "bench.h"
+
+/// headless composer_update_all (and composer_animate) over a synthetic tree of depth x fan-out elements
+/// usage: bench-composer [depth=4] [fan=8] [frames=100]
+/// prints one JSON object per phase: mount, update, restyle, reload, unmount
+
+static cstr css_file = "bench-composer.css";
+
+static none write_css(i32 variant, i32 fan) {
+    FILE* f = fopen(css_file, "w");
+    verify(f, "cannot write %s", css_file);
+    fprintf(f,
+        "element { fill-color: #2020%02x; border-size: 1; border-color: #404040; opacity: 1; }\n"
+        "element:hover { fill-color: #3030%02x, 200ms ease out; opacity: 0.9, 150ms; }\n",
+        variant & 0xff, variant & 0xff);
+    for (i32 i = 0; i < fan; i++) {
+        fprintf(f, ".e%i { border-radius-x: %i; border-radius-y: %i;\n", i, i % 8, i % 8);
+        fprintf(f, "    element:hover { border-color: #8080%02x, 100ms cubic in_out; }\n}\n", i & 0xff);
+        fprintf(f, "element.e%i / element.e%i { text-color: #ffffff; }\n", i, (i + 1) % fan);
+    }
+    fclose(f);
+    /// style reloads on a changed modification time; make sure each variant has its own
+    struct timeval tv[2];
+    gettimeofday(&tv[0], NULL);
+    tv[0].tv_sec += variant;
+    tv[1] = tv[0];
+    utimes(css_file, tv);
+}
+
+static element gen_element(i32 depth, i32 fan, i32 level, i32 index, i32* count, bool flip);
+
+static map gen_children(i32 depth, i32 fan, i32 level, i32* count, bool flip) {
+    map m = map(hsize, fan * 2);
+    for (i32 i = 0; i < fan; i++) {
+        element e = gen_element(depth, fan, level, i, count, flip);
+        set(m, e->id, e);
+    }
+    return m;
+}
+
+static element gen_element(i32 depth, i32 fan, i32 level, i32 index, i32* count, bool flip) {
+    (*count)++;
+    bool   on = (index & 1) ^ flip;
+    string id = f(string, "e%i", index);
+    map    children = level + 1 < depth ? gen_children(depth, fan, level + 1, count, flip) : null;
+    return element(
+        id,       id,
+        tags,     a(string(on ? "on" : "off")),
+        hover,    on,
+        elements, children);
+}
+
+static none report(bench_phase* p, i32 depth, i32 fan, i32 elements, i32 frames) {
+    printf("{\"bench\":\"composer\",\"phase\":\"%s\",\"depth\":%i,\"fan\":%i,\"elements\":%i,"
+           "\"frames\":%i,\"ns_per_frame\":%.1f,\"ns_per_element\":%.2f,"
+           "\"allocs_per_frame\":%.1f,\"frees_per_frame\":%.1f}\n",
+        p->name, depth, fan, elements, frames,
+        (f64)p->nanos / frames, (f64)p->nanos / frames / (elements ? elements : 1),
+        (f64)p->allocs / frames, (f64)p->frees / frames);
+    fflush(stdout);
+}
+
+static map gen_root(i32 depth, i32 fan, i32* count, bool flip) {
+    *count = 0;
+    return gen_children(depth, fan, 0, count, flip);
+}
+
+int main(int argc, cstr argv[]) {
+    i32 depth  = bench_arg(argc, argv, "depth",  4);
+    i32 fan    = bench_arg(argc, argv, "fan",    8);
+    i32 frames = bench_arg(argc, argv, "frames", 100);
+    i32 count  = 0;
+
+    write_css(0, fan);
+    composer ux = composer(
+        style,      style(form(path, "%s", css_file)),
+        bounds,     rect(x, 0.0f, y, 0.0f, w, 1920.0f, h, 1080.0f),
+        frame_step, 16666667); /// fixed 60hz timeline; transitions advance identically each run
+
+    /// each frame renders a freshly built tree, as an app would; building it is not timed
+    bench_phase p;
+    map         tree = gen_root(depth, fan, &count, false);
+    bench_start(&p, "mount");
+    update_all(ux, tree);
+    bench_stop(&p);
+    report(&p, depth, fan, count, 1);
+
+    /// same args every frame: apply_args finds nothing changed
+    bench_start(&p, "update");
+    for (i32 i = 0; i < frames; i++) {
+        bench_pause(&p);
+        tree = gen_root(depth, fan, &count, false);
+        bench_resume(&p);
+        update_all(ux, tree);
+        animate(ux); /// steps transitions by frame_step, as the compositor would each frame
+    }
+    bench_stop(&p);
+    report(&p, depth, fan, count, frames);
+
+    /// tags and hover flip on every element, each frame
+    bench_start(&p, "restyle");
+    for (i32 i = 0; i < frames; i++) {
+        bench_pause(&p);
+        tree = gen_root(depth, fan, &count, (i & 1) == 0);
+        bench_resume(&p);
+        update_all(ux, tree);
+        animate(ux); /// steps transitions by frame_step, as the compositor would each frame
+    }
+    bench_stop(&p);
+    report(&p, depth, fan, count, frames);
+
+    i32 reloads = frames < 10 ? frames : 10;
+    bench_start(&p, "reload");
+    for (i32 i = 0; i < reloads; i++) {
+        bench_pause(&p);
+        write_css(1 + i, fan);
+        tree = gen_root(depth, fan, &count, false);
+        bench_resume(&p);
+        /// the file is read on a worker and parsed in adopt; wait so the phase includes both
+        check_reload(ux->style);
+        while (__atomic_load_n(&ux->style->compiling, __ATOMIC_ACQUIRE))
+            sched_yield();
+        update_all(ux, tree);
+    }
+    bench_stop(&p);
+    report(&p, depth, fan, count, reloads);
+
+    tree = map(hsize, 1);
+    bench_start(&p, "unmount");
+    update_all(ux, tree);
+    bench_stop(&p);
+    report(&p, depth, fan, count, 1);
+
+    remove(css_file);
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include <import>
+#include <stdarg.h>
+#include "bench.h"
+
+/// stylesheet parse and match microbenchmarks over a generated corpus
+/// usage: bench-style [blocks=2000] [depth=2] [chain=3] [elements=2000] [iters=20] [seed=1]
+/// prints one JSON object per measurement: parse, compute, best_match, score
+
+static u32 rng;
+
+static u32 next_rand() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static cstr types[] = { "element", "pane", "button" };
+static cstr props[] = { "fill-color", "border-color", "text-color", "opacity", "border-size",
+                        "border-radius-x", "fill-radius-y", "text-scale", "fill-blur" };
+static cstr ops[]   = { "=", "!=", ">=", "<=", ">", "<" };
+static cstr eases[] = { "linear", "quad", "cubic", "sine", "expo", "back" };
+
+typedef struct corpus {
+    char* chars;
+    i64   len, alloc;
+    i32   blocks;
+} corpus;
+
+static none emit(corpus* c, cstr fmt, ...) {
+    va_list args;
+    for (;;) {
+        va_start(args, fmt);
+        i64 room = c->alloc - c->len;
+        i64 n    = vsnprintf(&c->chars[c->len], room, fmt, args);
+        va_end(args);
+        if (n < room) {
+            c->len += n;
+            return;
+        }
+        c->alloc = (c->alloc + n) * 2;
+        c->chars = realloc(c->chars, c->alloc);
+    }
+}
+
+/// type.id, optionally with a :state or state-op-value qualifier
+static none emit_qualifier(corpus* c, i32 ids) {
+    emit(c, "%s.q%u", types[next_rand() % 3], next_rand() % ids);
+    switch (next_rand() % 4) {
+        case 0: emit(c, ":hover"); break;
+        case 1: emit(c, ":tab_index%s%u", ops[next_rand() % 6], next_rand() % 4); break;
+        default: break;
+    }
+}
+
+static none emit_block(corpus* c, i32 depth, i32 chain, i32 ids, i32 indent) {
+    c->blocks++;
+    emit(c, "%*s", indent * 4, "");
+    i32 links = 1 + next_rand() % chain; /// parent / child qualifier chain
+    for (i32 i = 0; i < links; i++) {
+        if (i) emit(c, " / ");
+        emit_qualifier(c, ids);
+    }
+    if (next_rand() % 3 == 0) {
+        emit(c, ", ");
+        emit_qualifier(c, ids);
+    }
+    emit(c, " {\n");
+    i32 entries = 1 + next_rand() % 5;
+    for (i32 i = 0; i < entries; i++) {
+        cstr p = props[next_rand() % (sizeof(props) / sizeof(cstr))];
+        emit(c, "%*s%s: %u", indent * 4 + 4, "", p, next_rand() % 256);
+        if (next_rand() % 3 == 0)
+            emit(c, ", %ums %s out", 50 + next_rand() % 400, eases[next_rand() % 6]);
+        emit(c, ";\n");
+    }
+    if (depth > 0 && next_rand() % 2)
+        emit_block(c, depth - 1, chain, ids, indent + 1);
+    emit(c, "%*s}\n", indent * 4, "");
+}
+
+static corpus generate(i32 blocks, i32 depth, i32 chain, i32 ids) {
+    corpus c = { 0 };
+    c.alloc = 4096;
+    c.chars = malloc(c.alloc);
+    c.chars[0] = 0;
+    while (c.blocks < blocks)
+        emit_block(&c, depth, chain, ids, 0);
+    return c;
+}
+
+static none report(cstr measure, f64 nanos, i64 ops, cstr unit, f64 rate, i64 retained, i32 blocks) {
+    printf("{\"bench\":\"style\",\"measure\":\"%s\",\"ops\":%lli,\"ns_per_op\":%.1f,"
+           "\"%s\":%.2f,\"retained_bytes_per_block\":%.1f}\n",
+        measure, (long long)ops, nanos / (ops ? ops : 1), unit, rate,
+        blocks ? (f64)retained / blocks : 0.0);
+    fflush(stdout);
+}
+
+int main(int argc, cstr argv[]) {
+    i32 blocks   = bench_arg(argc, argv, "blocks",   2000);
+    i32 depth    = bench_arg(argc, argv, "depth",    2);
+    i32 chain    = bench_arg(argc, argv, "chain",    3);
+    i32 count    = bench_arg(argc, argv, "elements", 2000);
+    i32 iters    = bench_arg(argc, argv, "iters",    20);
+    rng          = bench_arg(argc, argv, "seed",     1) | 1;
+    i32 ids      = 32;
+
+    corpus c    = generate(blocks, depth, chain, ids);
+    string code = string(chars, c.chars, ref_length, c.len);
+
+    /// parse: process builds the blocks and publishes them indexed by prop
+    style st = null;
+    i64   retained = 0;
+    bench_phase p;
+    bench_start(&p, "parse");
+    for (i32 i = 0; i < iters; i++) {
+        if (st) drop(st);
+        i64 before = bench_get(bench_bytes);
+        st = hold(new(style));
+        process(st, code);
+        retained = bench_get(bench_bytes) - before;
+    }
+    bench_stop(&p);
+    report("parse", (f64)p.nanos, iters, "mb_per_s",
+        ((f64)c.len * iters / (1024.0 * 1024.0)) / ((f64)p.nanos / 1e9), retained, c.blocks);
+
+    /// elements in parent chains, so / qualifiers have something to walk
+    element* els = calloc(count, sizeof(element));
+    for (i32 i = 0; i < count; i++) {
+        switch (next_rand() % 3) {
+            case 0:  els[i] = hold(new(element));         break;
+            case 1:  els[i] = hold((element)new(pane));   break;
+            default: els[i] = hold((element)new(button)); break;
+        }
+        els[i]->id        = hold(f(string, "q%u", next_rand() % ids));
+        els[i]->hover     = next_rand() % 2;
+        els[i]->tab_index = next_rand() % 4;
+        els[i]->parent    = i % 4 ? (ion)els[i - 1] : null;
+    }
+
+    /// compute: applicable entries per prop (block score without state)
+    /// single threaded and never reloaded, so the entries stay valid without an epoch
+    style_avail** avail = calloc(count, sizeof(style_avail*));
+    bench_start(&p, "compute");
+    for (i32 it = 0; it < iters; it++)
+        for (i32 i = 0; i < count; i++) {
+            style_avail_free(avail[i]);
+            avail[i] = compute(st, els[i]);
+        }
+    bench_stop(&p);
+    report("compute", (f64)p.nanos, (i64)iters * count, "elements_per_s",
+        (f64)iters * count / ((f64)p.nanos / 1e9), 0, 0);
+
+    /// best_match: state-scored selection among the applicable entries
+    i64 matches = 0;
+    bench_start(&p, "best_match");
+    for (i32 it = 0; it < iters; it++)
+        for (i32 i = 0; i < count; i++)
+            for (i32 k = 0; k < avail[i]->count; k++) {
+                best_match(st, els[i], avail[i]->props[k], avail[i]->entries[k]);
+                matches++;
+            }
+    bench_stop(&p);
+    report("best_match", (f64)p.nanos, matches, "matches_per_s",
+        (f64)matches / ((f64)p.nanos / 1e9), 0, 0);
+
+    /// score: every top-level block against every element
+    i64 scores = 0;
+    bench_start(&p, "score");
+    for (i32 i = 0; i < count; i++)
+        each(st->base, style_block, bl) {
+            score(bl, els[i], true);
+            scores++;
+        }
+    bench_stop(&p);
+    report("score", (f64)p.nanos, scores, "scores_per_s",
+        (f64)scores / ((f64)p.nanos / 1e9), 0, 0);
+
+    for (i32 i = 0; i < count; i++) {
+        style_avail_free(avail[i]);
+        drop(els[i]);
+    }
+    free(avail);
+    free(els);
+    drop(st);
+    free(c.chars);
+    return 0;
+}
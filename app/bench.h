@@ -0,0 +1,102 @@
+#ifndef _BENCH_
+#define _BENCH_
+
+/// shared by the bench apps: heap accounting by interposing the libc allocator,
+/// a monotonic clock, and one JSON object per line on stdout for result collection
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+
+extern void* __libc_malloc (size_t);
+extern void* __libc_calloc (size_t, size_t);
+extern void* __libc_realloc(void*, size_t);
+extern void  __libc_free   (void*);
+
+/// atomic: style compiles, task workers and the compositor allocate on their own threads
+static long long bench_allocs;
+static long long bench_frees;
+static long long bench_bytes;   /// live heap, by usable size
+
+#define bench_add(v, n) __atomic_fetch_add(&(v), (n), __ATOMIC_RELAXED)
+#define bench_get(v)    __atomic_load_n(&(v), __ATOMIC_RELAXED)
+
+void* malloc(size_t n) {
+    void* p = __libc_malloc(n);
+    bench_add(bench_allocs, 1);
+    bench_add(bench_bytes, p ? (long long)malloc_usable_size(p) : 0);
+    return p;
+}
+
+void* calloc(size_t c, size_t n) {
+    void* p = __libc_calloc(c, n);
+    bench_add(bench_allocs, 1);
+    bench_add(bench_bytes, p ? (long long)malloc_usable_size(p) : 0);
+    return p;
+}
+
+void* realloc(void* p, size_t n) {
+    if (!p) bench_add(bench_allocs, 1);
+    bench_add(bench_bytes, p ? -(long long)malloc_usable_size(p) : 0);
+    void* r = __libc_realloc(p, n);
+    bench_add(bench_bytes, r ? (long long)malloc_usable_size(r) : 0);
+    return r;
+}
+
+void free(void* p) {
+    if (p) {
+        bench_add(bench_frees, 1);
+        bench_add(bench_bytes, -(long long)malloc_usable_size(p));
+    }
+    __libc_free(p);
+}
+
+static long long bench_nanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+/// one measured phase: elapsed time and heap traffic between start and stop,
+/// less whatever ran between bench_pause and bench_resume (input setup)
+typedef struct bench_phase {
+    const char* name;
+    long long   start, nanos;
+    long long   allocs, frees;
+    long long   at_allocs, at_frees;
+} bench_phase;
+
+static void bench_resume(bench_phase* p) {
+    p->at_allocs = bench_get(bench_allocs);
+    p->at_frees  = bench_get(bench_frees);
+    p->start     = bench_nanos();
+}
+
+static void bench_pause(bench_phase* p) {
+    p->nanos  += bench_nanos() - p->start;
+    p->allocs += bench_get(bench_allocs) - p->at_allocs;
+    p->frees  += bench_get(bench_frees)  - p->at_frees;
+}
+
+static void bench_start(bench_phase* p, const char* name) {
+    p->name   = name;
+    p->nanos  = 0;
+    p->allocs = 0;
+    p->frees  = 0;
+    bench_resume(p);
+}
+
+static void bench_stop(bench_phase* p) {
+    bench_pause(p);
+}
+
+static int bench_arg(int argc, char** argv, const char* name, int def) {
+    size_t ln = strlen(name);
+    for (int i = 1; i < argc; i++)
+        if (strncmp(argv[i], name, ln) == 0 && argv[i][ln] == '=')
+            return atoi(&argv[i][ln + 1]);
+    return def;
+}
+
+#endif
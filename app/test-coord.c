@@ -0,0 +1,142 @@
+#include <import>
+#include "test.h"
+
+/// coord, region and alignment strings: the single-pass parsers, where the parsed values place rects,
+/// and interning (equal values shared by one instance, whether they come from args or style)
+/// usage: test-coord
+
+static bool rect_is(rect r, f32 x, f32 y, f32 w, f32 h) {
+    return r && r->x == x && r->y == y && r->w == w && r->h == h;
+}
+
+static none test_coord() {
+    coord a = coord(string("l10 t5"));
+    test_check(a->x_type == xalign_left && a->y_type == yalign_top, "types %i %i", a->x_type, a->y_type);
+    test_check(a->offset.x == 10.0f && a->offset.y == 5.0f, "offset %f %f", a->offset.x, a->offset.y);
+    test_check(!a->x_per && !a->y_per && !a->x_rel && !a->y_rel, "no flags");
+    test_check(a->align && a->align->x == 0.0f && a->align->y == 0.0f, "left top aligns at 0 0");
+
+    /// the type letter may be spelled out
+    coord b = coord(string("left10 top5"));
+    test_check(b->x_type == a->x_type && b->y_type == a->y_type &&
+               b->offset.x == 10.0f && b->offset.y == 5.0f, "'left10 top5' reads as 'l10 t5'");
+
+    coord c = coord(string("r10% b5+"));
+    test_check(c->x_type == xalign_right && c->y_type == yalign_bottom, "types %i %i", c->x_type, c->y_type);
+    test_check(c->x_per && !c->x_rel && !c->y_per && c->y_rel, "r10%% b5+ flags");
+    test_check(c->align->x == 1.0f && c->align->y == 1.0f, "right bottom aligns at 1 1");
+
+    coord m = coord(string("  m0   m-2.5 "));
+    test_check(m->x_type == xalign_middle && m->y_type == yalign_middle, "middle types");
+    test_check(m->offset.y == -2.5f, "offset y %f", m->offset.y);
+    test_check(m->align->x == 0.5f && m->align->y == 0.5f, "middle aligns at 0.5");
+
+    coord w = coord(string("w40 h20"));
+    test_check(w->x_type == xalign_width && w->y_type == yalign_height, "size types");
+}
+
+static none test_alignment() {
+    alignment a = alignment(string("middle"));
+    test_check(a->x == 0.5f && a->y == 0.5f, "one value applies to both: %f %f", a->x, a->y);
+    alignment b = alignment(string("0.25 1"));
+    test_check(b->x == 0.25f && b->y == 1.0f, "numbers: %f %f", b->x, b->y);
+    alignment c = alignment(string("right bottom"));
+    test_check(c->x == 1.0f && c->y == 1.0f, "names: %f %f", c->x, c->y);
+    alignment d = alignment(string("r t"));
+    test_check(d->x == 1.0f && d->y == 0.0f, "initials: %f %f", d->x, d->y);
+    alignment e = alignment(string("0.75"));
+    test_check(e->x == 0.75f && e->y == 0.75f, "one number: %f %f", e->x, e->y);
+}
+
+static none test_region() {
+    rect win = rect(x, 50.0f, y, 20.0f, w, 200.0f, h, 100.0f);
+
+    region full = region(string("l0 t0 r0 b0"));
+    test_check(full->set, "region is set");
+    test_check(full->tl->x_type == xalign_left  && full->tl->y_type == yalign_top,    "tl types");
+    test_check(full->br->x_type == xalign_right && full->br->y_type == yalign_bottom, "br types");
+    test_check(rect_is(relative_rect(full, win, 0.0f, 0.0f), 0, 0, 200, 100), "l0 t0 r0 b0 fills the window");
+
+    /// br in width and height is a size from tl
+    region box = region(string("l10 t10 w40 h30"));
+    test_check(rect_is(relative_rect(box, win, 0.0f, 0.0f), 10, 10, 40, 30), "l10 t10 w40 h30");
+
+    /// a single value insets every side by it
+    region inset = region(string("10"));
+    test_check(inset->tl->x_type == xalign_left  && inset->tl->y_type == yalign_top &&
+               inset->br->x_type == xalign_right && inset->br->y_type == yalign_bottom, "inset types");
+    test_check(!inset->tl->x_per && !inset->br->y_per, "plain inset is not a percentage");
+    test_check(rect_is(relative_rect(inset, win, 0.0f, 0.0f), 10, 10, 180, 80), "inset 10");
+
+    /// a percentage inset is a share of each axis: 5% of 200 across, 5% of 100 down
+    region per = region(string("5%"));
+    test_check(per->tl->x_per && per->tl->y_per && per->br->x_per && per->br->y_per, "percentage inset flags");
+    test_check(rect_is(relative_rect(per, win, 0.0f, 0.0f), 10, 5, 180, 90), "inset 5%%");
+
+    /// the f32 constructor is the same single inset
+    rect from_f32 = relative_rect(region(4.0f),             win, 0.0f, 0.0f);
+    rect from_str = relative_rect(region(string(" 4")), win, 0.0f, 0.0f);
+    test_check(rect_is(from_f32, 4, 4, 192, 92) && rect_is(from_str, 4, 4, 192, 92), "inset 4 both ways");
+}
+
+static cstr css_file = "test-coord.css";
+
+static element mounted(composer ux, cstr id) {
+    return (element)get(ux->root->elements, string(id));
+}
+
+static none test_intern() {
+    /// coords align through the table; equal alignments are one instance
+    coord lt0 = coord(string("l0 t0"));
+    coord lt1 = coord(string("left10 t5%"));
+    coord mm  = coord(string("m0 m0"));
+    test_check(lt0->align == lt1->align, "equal alignments are separate instances");
+    test_check(lt0->align != mm->align,  "different alignments share an instance");
+
+    FILE* f = fopen(css_file, "w");
+    verify(f, "cannot write %s", css_file);
+    fprintf(f, "element { text-area: l2 t2 r2 b2; }\n");
+    fclose(f);
+    composer ux = composer(
+        style,  style(form(path, "%s", css_file)),
+        bounds, rect(x, 0.0f, y, 0.0f, w, 200.0f, h, 100.0f));
+
+    /// args built separately, with equal values
+    map render = map(hsize, 8);
+    set(render, string("a"), element(id, string("a"), area, region(string("l0 t0 w10 h10"))));
+    set(render, string("b"), element(id, string("b"), area, region(string("l0 t0 w10 h10"))));
+    set(render, string("c"), element(id, string("c"), area, region(string("l0 t0 w20 h20"))));
+    update_all(ux, render);
+
+    element a = mounted(ux, "a");
+    element b = mounted(ux, "b");
+    element c = mounted(ux, "c");
+    test_check(a && b && c, "elements mounted");
+    if (a && b && c) {
+        test_check(a->area == b->area, "equal area args are separate instances");
+        test_check(a->area != c->area, "different area args share an instance");
+        test_check(a->area->tl == c->area->tl, "equal corners of different regions are separate instances");
+        test_check(a->area->br != c->area->br, "different corners share an instance");
+
+        /// one style entry, decoded once, for every element it applies to
+        test_check(a->text_area && a->text_area == b->text_area && b->text_area == c->text_area,
+            "styled regions are separate instances");
+
+        /// a later frame with fresh, equal args keeps the instance (and sees nothing changed)
+        region prev = a->area;
+        render = map(hsize, 8);
+        set(render, string("a"), element(id, string("a"), area, region(string("l0 t0 w10 h10"))));
+        update_all(ux, render);
+        a = mounted(ux, "a");
+        test_check(a && a->area == prev, "a fresh equal arg replaced the interned instance");
+    }
+    remove(css_file);
+}
+
+int main(int argc, cstr argv[]) {
+    test_coord();
+    test_alignment();
+    test_region();
+    test_intern();
+    return test_done("coord");
+}
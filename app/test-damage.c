@@ -0,0 +1,97 @@
+#include <import>
+#include "test.h"
+
+/// damage rects from update_all: nothing for an identical frame, a moved element's old and new areas,
+/// overlapping rects merged, and past DAMAGE_MAX (8) merged down without losing any area
+/// usage: test-damage
+
+static cstr css_file = "test-damage.css";
+
+static element box(cstr id, f32 x, f32 y, f32 w, f32 h) {
+    char area[64];
+    snprintf(area, sizeof(area), "l%g t%g w%g h%g", x, y, w, h);
+    return element(id, string(id), area, region(string(area)));
+}
+
+static none put(map render, element e) {
+    set(render, e->id, e);
+}
+
+static bool covered(array damage, f32 x, f32 y, f32 w, f32 h) {
+    each(damage, rect, r)
+        if (r->x <= x && r->y <= y && r->x + r->w >= x + w && r->y + r->h >= y + h)
+            return true;
+    return false;
+}
+
+static bool rect_is(rect r, f32 x, f32 y, f32 w, f32 h) {
+    return r && r->x == x && r->y == y && r->w == w && r->h == h;
+}
+
+int main(int argc, cstr argv[]) {
+    FILE* f = fopen(css_file, "w");
+    verify(f, "cannot write %s", css_file);
+    fprintf(f, "element { fill-color: #ff0000; }\n");
+    fclose(f);
+    composer ux = composer(
+        style,  style(form(path, "%s", css_file)),
+        bounds, rect(x, 0.0f, y, 0.0f, w, 200.0f, h, 200.0f));
+
+    /// first frame: everything is new, and the root's fill covers the window
+    map render = map(hsize, 4);
+    put(render, box("a", 10, 10,  40, 40));
+    put(render, box("b", 10, 150, 20, 20));
+    array damage = update_all(ux, render);
+    test_check(len(damage) == 1 && rect_is(get(damage, 0), 0, 0, 200, 200),
+        "first frame damages the window: %i rects", (int)len(damage));
+
+    /// same args: nothing to repaint
+    render = map(hsize, 4);
+    put(render, box("a", 10, 10,  40, 40));
+    put(render, box("b", 10, 150, 20, 20));
+    damage = update_all(ux, render);
+    test_check(len(damage) == 0, "identical frame damages %i rects", (int)len(damage));
+
+    /// a small move: where it was and where it is overlap, and merge into one rect
+    render = map(hsize, 4);
+    put(render, box("a", 20, 10,  40, 40));
+    put(render, box("b", 10, 150, 20, 20));
+    damage = update_all(ux, render);
+    test_check(len(damage) == 1 && rect_is(get(damage, 0), 10, 10, 50, 40),
+        "overlapping move: %i rects", (int)len(damage));
+    test_check(!covered(damage, 10, 150, 20, 20), "an unchanged element was damaged");
+
+    /// a far move: two separate rects
+    render = map(hsize, 4);
+    put(render, box("a", 100, 10, 40, 40));
+    put(render, box("b", 10, 150, 20, 20));
+    damage = update_all(ux, render);
+    test_check(len(damage) == 2, "far move: %i rects", (int)len(damage));
+    test_check(covered(damage, 20, 10, 40, 40) && covered(damage, 100, 10, 40, 40),
+        "far move damages where it was and where it is");
+    test_check(!covered(damage, 10, 150, 20, 20), "an unchanged element was damaged");
+
+    /// twelve separate elements moving at once: merged down to the limit, every moved area still covered
+    for (i32 frame = 0; frame < 2; frame++) {
+        render = map(hsize, 16);
+        for (i32 i = 0; i < 12; i++) {
+            char id[8];
+            snprintf(id, sizeof(id), "m%i", i);
+            put(render, box(id, (i % 4) * 50 + 5 + frame, (i / 4) * 60 + 5, 20, 20));
+        }
+        damage = update_all(ux, render);
+        test_check(len(damage) > 0 && len(damage) <= 8, "frame %i: %i rects", frame, (int)len(damage));
+        for (i32 i = 0; i < 12; i++) {
+            f32 x = (i % 4) * 50 + 5, y = (i / 4) * 60 + 5;
+            test_check(covered(damage, x + frame, y, 20, 20), "frame %i: m%i is not covered", frame, i);
+            if (frame)
+                test_check(covered(damage, x, y, 20, 20), "m%i's previous area is not covered", i);
+        }
+        if (!frame)
+            test_check(covered(damage, 100, 10, 40, 40) && covered(damage, 10, 150, 20, 20),
+                "unmounted elements did not damage where they were");
+    }
+
+    remove(css_file);
+    return test_done("damage");
+}
@@ -0,0 +1,273 @@
+#include <import>
+#include "test.h"
+
+/// text: the piece treap against a flat reference buffer, offsets and positions, snapshot and restore,
+/// the row height index behind virtualized layout, and the undo journal
+/// usage: test-text [edits=2000] [seed=1]
+
+static u32 rng;
+
+static u32 next_rand() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static int arg(int argc, cstr argv[], cstr name, int def) {
+    sz ln = strlen(name);
+    for (int i = 1; i < argc; i++)
+        if (strncmp(argv[i], name, ln) == 0 && argv[i][ln] == '=')
+            return atoi(&argv[i][ln + 1]);
+    return def;
+}
+
+/// the whole document
+static string doc(text a) {
+    return extract(a, text_sel(row, 0, column, 0),
+                      text_sel(row, line_count(a) - 1, column, (num)1 << 40));
+}
+
+static text_sel at(text a, i64 o) {
+    text_sel s = new(text_sel);
+    position(a, o, s);
+    return s;
+}
+
+static none test_basics() {
+    text a = text(string("hello\nworld"));
+    test_check(line_count(a) == 2, "%lli lines", (long long)line_count(a));
+    test_check(char_count(a) == 11, "%lli chars", (long long)char_count(a));
+    line_info l = line(a, 1);
+    test_check(test_is(l->data->chars, l->len, "world"), "row 1 is '%s'", l->data->chars);
+
+    text_sel from = text_sel(row, 0, column, 5);
+    text_sel to   = text_sel(row, 0, column, 5);
+    replace(a, from, to, string(", there"));
+    l = line(a, 0);
+    test_check(test_is(l->data->chars, l->len, "hello, there"), "row 0 is '%s'", l->data->chars);
+    test_check(from->row == 0 && from->column == 12 && to->column == 12,
+        "caret at %lli:%lli", (long long)from->row, (long long)from->column);
+
+    /// a selection across the newline joins the rows
+    replace(a, text_sel(row, 0, column, 5), text_sel(row, 1, column, 0), string(" "));
+    string d = doc(a);
+    test_check(test_is(d->chars, d->len, "hello world"), "doc is '%s'", d->chars);
+    test_check(line_count(a) == 1, "%lli lines", (long long)line_count(a));
+
+    /// columns past the end of a row clamp to it
+    test_check(offset(a, text_sel(row, 0, column, 99)) == 11, "clamped offset");
+
+    text empty = text(string(""));
+    test_check(line_count(empty) == 1 && char_count(empty) == 0, "empty text is one empty row");
+}
+
+/// random inserts and deletes, checked against a flat buffer after every edit
+static none test_treap(i32 edits) {
+    i64   alloc = 1 << 16;
+    char* ref   = calloc(alloc, 1);
+    i64   len   = 0;
+    text  a     = text(string(""));
+    static cstr words[] = { "a", "bc", "\n", "def\n", "ghij", "\n\n", "klmnopq", "rs\ntu" };
+
+    for (i32 i = 0; i < edits; i++) {
+        i64  o0  = len ? next_rand() % (len + 1) : 0;
+        i64  del = (next_rand() & 3) == 0 && len > o0 ? next_rand() % min(len - o0, (i64)16) : 0;
+        cstr ins = (next_rand() & 7) == 0 ? "" : words[next_rand() % (sizeof(words) / sizeof(cstr))];
+        i64  n   = strlen(ins);
+        if (len - del + n >= alloc)
+            break;
+
+        text_sel from = at(a, o0);
+        text_sel to   = at(a, o0 + del);
+        replace(a, from, to, string(ins));
+        memmove(&ref[o0 + n], &ref[o0 + del], len - o0 - del);
+        memcpy(&ref[o0], ins, n);
+        len += n - del;
+
+        test_check(char_count(a) == len, "edit %i: %lli chars, expected %lli",
+            i, (long long)char_count(a), (long long)len);
+        test_check(offset(a, from) == o0 + n, "edit %i: caret lands after the insert", i);
+        if (char_count(a) != len)
+            break;
+    }
+
+    string d = doc(a);
+    test_check(d->len == len && memcmp(d->chars, ref, len) == 0, "document differs from the reference");
+    i64 lines = 1;
+    for (i64 i = 0; i < len; i++)
+        lines += ref[i] == '\n';
+    test_check(line_count(a) == lines, "%lli lines, expected %lli",
+        (long long)line_count(a), (long long)lines);
+
+    /// every row reads back as the reference between its newlines, and positions round-trip
+    i64 start = 0, row = 0;
+    for (i64 i = 0; i <= len; i++) {
+        if (i < len && ref[i] != '\n')
+            continue;
+        line_info l = line(a, row);
+        test_check(l->len == i - start && memcmp(l->data->chars, &ref[start], l->len) == 0,
+            "row %lli differs", (long long)row);
+        text_sel s = at(a, i);
+        test_check(s->row == row && s->column == i - start && offset(a, s) == i,
+            "offset %lli does not round-trip", (long long)i);
+        start = i + 1;
+        row++;
+    }
+    free(ref);
+}
+
+static none test_snapshot() {
+    text   a    = text(string("one\ntwo\nthree"));
+    text   snap = snapshot(a);
+    string d0   = doc(a);
+
+    replace(a, text_sel(row, 1, column, 0), text_sel(row, 1, column, 3), string("2"));
+    replace(a, text_sel(row, 0, column, 0), text_sel(row, 0, column, 0), string("zero\n"));
+    string d1 = doc(a);
+    test_check(test_is(d1->chars, d1->len, "zero\none\n2\nthree"), "edited doc is '%s'", d1->chars);
+
+    string ds = doc(snap);
+    test_check(ds->len == d0->len && memcmp(ds->chars, d0->chars, d0->len) == 0,
+        "snapshot changed with the text: '%s'", ds->chars);
+    test_check(line_count(snap) == 3, "snapshot has %lli lines", (long long)line_count(snap));
+
+    restore(a, snap);
+    string dr = doc(a);
+    test_check(dr->len == d0->len && memcmp(dr->chars, d0->chars, d0->len) == 0,
+        "restored doc is '%s'", dr->chars);
+    test_check(line_count(a) == 3, "restored text has %lli lines", (long long)line_count(a));
+    line_info l = line(a, 1);
+    test_check(test_is(l->data->chars, l->len, "two"), "restored row 1 is '%s'", l->data->chars);
+    test_check(!undo(a, null), "restore clears the history");
+
+    /// the text stays editable after a restore, and the snapshot stays put
+    replace(a, text_sel(row, 2, column, 5), text_sel(row, 2, column, 5), string("!"));
+    l = line(a, 2);
+    test_check(test_is(l->data->chars, l->len, "three!"), "row 2 is '%s'", l->data->chars);
+    ds = doc(snap);
+    test_check(test_is(ds->chars, ds->len, "one\ntwo\nthree"), "snapshot is '%s'", ds->chars);
+}
+
+/// monospace metrics: 8 pixels a glyph, 10 a line
+static f64 mono_advance(font f, u32 cp) { return 8.0; }
+static f64 mono_height (font f)         { return 10.0; }
+
+static none test_rows() {
+    text_metrics(mono_advance, mono_height);
+    char buf[1024];
+    i32  n = 0;
+    for (i32 i = 0; i < 100; i++)
+        n += snprintf(&buf[n], sizeof(buf) - n, i ? "\nrow" : "row");
+    text a = text(string(buf));
+    test_check(line_count(a) == 100, "%lli lines", (long long)line_count(a));
+
+    /// only the rows in view are measured; the rest count one line_height each
+    f64 total = layout(a, (font)null, 10.0, 0.0, 0.0, 50.0);
+    test_check(total == 1000.0, "document height %f", total);
+    test_check(a->view_first == 0 && a->view_count == 5,
+        "view %lli + %lli", (long long)a->view_first, (long long)a->view_count);
+    test_check(row_y(a, 0) == 0.0 && row_y(a, 5) == 50.0 && row_y(a, 100) == 1000.0, "row_y");
+    test_check(row_at(a, 0.0)  == 0 && row_at(a, 9.9) == 0 && row_at(a, 10.0) == 1, "row_at at edges");
+    test_check(row_at(a, 55.0) == 5 && row_at(a, 999.0) == 99, "row_at inside");
+    test_check(row_at(a, 5000.0) == 99, "row_at past the end clamps to the last row");
+
+    /// a wrapped row grows the index by its extra lines: 30 glyphs at 80 wide is 3 lines
+    replace(a, text_sel(row, 3, column, 0), text_sel(row, 3, column, 3),
+        string("xxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"));
+    total = layout(a, (font)null, 10.0, 80.0, 0.0, 100.0);
+    test_check(total == 1020.0, "wrapped document height %f", total);
+    test_check(row_y(a, 3) == 30.0 && row_y(a, 4) == 60.0, "rows after the wrapped row move down");
+    test_check(row_at(a, 45.0) == 3 && row_at(a, 60.0) == 4, "row_at across the wrapped row");
+
+    /// scrolled: the view starts at the row covering top
+    layout(a, (font)null, 10.0, 80.0, 500.0, 550.0);
+    test_check(a->view_first == 48, "view starts at row %lli", (long long)a->view_first);
+    line_info l = line(a, 48);
+    test_check(l->bounds && l->bounds->y == 500.0f, "row 48 placed at %f", l->bounds ? l->bounds->y : -1.0f);
+
+    /// rows inserted by an edit are estimated until they are seen
+    replace(a, text_sel(row, 0, column, 0), text_sel(row, 0, column, 0), string("\n\n"));
+    test_check(line_count(a) == 102, "%lli lines", (long long)line_count(a));
+    test_check(row_y(a, 102) == 1040.0, "height after the edit %f", row_y(a, 102));
+    test_check(row_y(a, 5) == 50.0 && row_y(a, 6) == 80.0, "the wrapped row kept its measure");
+    text_metrics(null, null);
+}
+
+/// s typed at the caret, as an editor sends it one keystroke at a time
+static none keystroke(text a, text_sel caret, cstr s) {
+    replace(a, caret, caret, string(s));
+}
+
+static bool doc_is(text a, cstr expect) {
+    string d = doc(a);
+    return test_is(d->chars, d->len, expect);
+}
+
+static none test_journal() {
+    /// keystrokes on a row merge into one op; a newline starts another
+    text     a     = text(string(""));
+    text_sel caret = text_sel(row, 0, column, 0);
+    keystroke(a, caret, "a");
+    keystroke(a, caret, "b");
+    keystroke(a, caret, "\n");
+    keystroke(a, caret, "c");
+    keystroke(a, caret, "d");
+    test_check(doc_is(a, "ab\ncd"), "typed doc is '%s'", doc(a)->chars);
+    test_check(undo(a, caret) && doc_is(a, "ab\n"), "undo 1: '%s'", doc(a)->chars);
+    test_check(caret->row == 1 && caret->column == 0,
+        "caret at %lli:%lli", (long long)caret->row, (long long)caret->column);
+    test_check(undo(a, caret) && doc_is(a, "ab"), "undo 2: '%s'", doc(a)->chars);
+    test_check(undo(a, caret) && doc_is(a, ""),   "undo 3: '%s'", doc(a)->chars);
+    test_check(!undo(a, caret), "nothing left to undo");
+    test_check(redo(a, caret) && doc_is(a, "ab"), "redo 1: '%s'", doc(a)->chars);
+    test_check(redo(a, caret) && redo(a, caret) && doc_is(a, "ab\ncd"), "redo 3: '%s'", doc(a)->chars);
+    test_check(!redo(a, caret), "nothing left to redo");
+
+    /// backspaces merge backward, deletes merge forward
+    text b = text(string("hello"));
+    replace(b, text_sel(row, 0, column, 4), text_sel(row, 0, column, 5), null);
+    replace(b, text_sel(row, 0, column, 3), text_sel(row, 0, column, 4), null);
+    test_check(doc_is(b, "hel"), "backspaced doc is '%s'", doc(b)->chars);
+    test_check(undo(b, null) && doc_is(b, "hello") && !undo(b, null), "backspaces undo as one");
+
+    text c = text(string("hello"));
+    replace(c, text_sel(row, 0, column, 1), text_sel(row, 0, column, 2), null);
+    replace(c, text_sel(row, 0, column, 1), text_sel(row, 0, column, 2), null);
+    test_check(doc_is(c, "hlo"), "deleted doc is '%s'", doc(c)->chars);
+    test_check(undo(c, null) && doc_is(c, "hello") && !undo(c, null), "deletes undo as one");
+
+    /// a selection replaced is one op both ways
+    text d = text(string("one two"));
+    replace(d, text_sel(row, 0, column, 4), text_sel(row, 0, column, 7), string("2"));
+    test_check(undo(d, null) && doc_is(d, "one two"), "undo replace: '%s'", doc(d)->chars);
+    test_check(redo(d, null) && doc_is(d, "one 2"),   "redo replace: '%s'", doc(d)->chars);
+
+    /// an edit after an undo drops what could be redone, and does not merge into the undone op
+    text e = text(string(""));
+    caret  = text_sel(row, 0, column, 0);
+    keystroke(e, caret, "x");
+    undo(e, caret);
+    keystroke(e, caret, "y");
+    test_check(doc_is(e, "y") && !redo(e, null), "redo survived a new edit");
+    test_check(undo(e, null) && doc_is(e, "") && !undo(e, null), "the new edit undoes alone");
+
+    /// a negative history_limit records nothing
+    text f = text(string("abc"));
+    f->history_limit = -1;
+    replace(f, text_sel(row, 0, column, 0), text_sel(row, 0, column, 1), null);
+    test_check(!undo(f, null) && doc_is(f, "bc"), "history was recorded with history_limit < 0");
+}
+
+int main(int argc, cstr argv[]) {
+    i32 edits = arg(argc, argv, "edits", 2000);
+    rng       = arg(argc, argv, "seed",  1);
+    if (!rng) rng = 1;
+
+    test_basics();
+    test_treap(edits);
+    test_snapshot();
+    test_rows();
+    test_journal();
+    return test_done("text");
+}
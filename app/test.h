@@ -0,0 +1,33 @@
+#ifndef _TEST_
+#define _TEST_
+
+/// shared by the test apps: failed checks print where they are and keep going;
+/// main returns test_done, one JSON object on stdout and a nonzero exit when anything failed
+#include <stdio.h>
+#include <string.h>
+
+static int test_checks;
+static int test_failures;
+
+#define test_check(cond, ...) do {                                      \
+    test_checks++;                                                      \
+    if (!(cond)) {                                                      \
+        test_failures++;                                                \
+        fprintf(stderr, "%s:%i: %s: ", __FILE__, __LINE__, #cond);      \
+        fprintf(stderr, __VA_ARGS__);                                   \
+        fputc('\n', stderr);                                            \
+    }                                                                   \
+} while (0)
+
+/// chars of an A string equal to a C string
+static int test_is(const char* chars, long long len, const char* expect) {
+    return chars && len == (long long)strlen(expect) && memcmp(chars, expect, len) == 0;
+}
+
+static int test_done(const char* name) {
+    printf("{\"test\":\"%s\",\"checks\":%i,\"failures\":%i}\n", name, test_checks, test_failures);
+    fflush(stdout);
+    return test_failures ? 1 : 0;
+}
+
+#endif
@@ -1,5 +1,9 @@
 #include <import>
 #include <math.h>
+#include <time.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <errno.h>
 
 static const real PI = 3.1415926535897932384; // M_PI;
 static const real c1 = 1.70158;
@@ -16,60 +20,96 @@ string coord_cast_string(coord a) {
         a->y_per ? "%" : "", a->y_rel ? "+" : "");
 }
 
+/// coord, region and alignment strings are scanned in a single pass, writing fields directly
+/// coord:      <x-type><num>[%][+] <y-type><num>[%][+]   such as l10% t5+
+/// alignment:  <x> [<y>], each a number or left/middle/right, top/middle/bottom
+static inline cstr skip_ws(cstr p) {
+    while (*p == ' ' || *p == '\t') p++;
+    return p;
+}
+
+static f32 xalign_unit(xalign t) {
+    switch (t) {
+        case xalign_middle: return 0.5f;
+        case xalign_right:  return 1.0f;
+        default:            return 0.0f; /// left, width
+    }
+}
+
+static f32 yalign_unit(yalign t) {
+    switch (t) {
+        case yalign_middle: return 0.5f;
+        case yalign_bottom: return 1.0f;
+        default:            return 0.0f; /// top, height
+    }
+}
+
+static i32 align_type(char c, bool is_y) {
+    if (c == 'm') return is_y ? yalign_middle : xalign_middle;
+    if (!is_y)
+        switch (c) {
+            case 'l': return xalign_left;
+            case 'r': return xalign_right;
+            case 'w': return xalign_width;
+        }
+    else
+        switch (c) {
+            case 't': return yalign_top;
+            case 'b': return yalign_bottom;
+            case 'h': return yalign_height;
+        }
+    return 0; /// undefined
+}
+
+/// one unit-value token; returns the cursor after it, or null when the type is not recognized
+static cstr scan_unit(cstr p, bool is_y, i32* type, f32* offset, bool* per, bool* rel) {
+    p     = skip_ws(p);
+    *type = align_type(*p, is_y);
+    if (!*type)
+        return null;
+    while (isalpha(*p)) p++; /// 'l10' and 'left10' read the same
+    char* end;
+    *offset = strtof(p, &end);
+    for (p = end; *p == '%' || *p == '+'; p++) {
+        if (*p == '%') *per = true;
+        else           *rel = true;
+    }
+    return p;
+}
+
+static alignment intern_alignment(f32 x, f32 y, bool set);
+
+static none coord_align(coord a) {
+    a->align = intern_alignment(xalign_unit(a->x_type), yalign_unit(a->y_type), false);
+}
+
+static cstr coord_scan(coord a, cstr p) {
+    i32 x_type, y_type;
+    p = scan_unit(p, false, &x_type, &a->offset.x, &a->x_per, &a->x_rel);
+    if (p)
+        p = scan_unit(p, true, &y_type, &a->offset.y, &a->y_per, &a->y_rel);
+    if (!p)
+        return null;
+    a->x_type = (xalign)x_type;
+    a->y_type = (yalign)y_type;
+    coord_align(a);
+    return p;
+}
+
+/// numeric coord; skips formatting a string only to parse it back
+static coord coord_from(xalign x_type, f32 x, yalign y_type, f32 y, bool per) {
+    coord a   = new(coord);
+    a->x_type = x_type;
+    a->y_type = y_type;
+    a->offset = vec2f(x, y);
+    a->x_per  = per;
+    a->y_per  = per;
+    coord_align(a);
+    return a;
+}
+
 coord coord_with_string(coord a, string s) {
-    array  sp = split(s, " ");
-    verify(sp, "expected unit-value token such as x-10");
-    verify(len(sp) == 2, "expected two values");
-    string sx = sp->elements[0];
-    string sy = sp->elements[1];
-    
-    /// set x/y types
-    a->x_type = e_val(xalign, sx->chars);
-    a->y_type = e_val(yalign, sy->chars);
-    string sx_offset = mid(sx, 1, len(sx) - 1);
-    string sy_offset = mid(sy, 1, len(sy) - 1);
-
-    /// get numeric attributes (percentage and relative)
-    if (last(sx_offset) == '%') {
-        sx_offset = mid(sx_offset, 0, len(sx_offset) - 1);
-        a->x_per = true;
-    }
-    if (last(sy_offset) == '%') {
-        sy_offset = mid(sy_offset, 0, len(sy_offset) - 1);
-        a->y_per = true;
-    }
-    if (sx_offset)
-        if (last(sx_offset) == '+') {
-            sx_offset = mid(sx_offset, 0, len(sx_offset) - 1);
-            a->x_rel = true;
-        }
-    if (sy_offset)
-        if (last(sy_offset) == '+') {
-            sy_offset = mid(sy_offset, 0, len(sy_offset) - 1);
-            a->y_rel = true;
-        }
-
-    /// set offset
-    a->offset = vec2f(
-        real_value(sx_offset), real_value(sy_offset));
-    
-    /// set align
-    f32 x = 0, y = 0;
-    switch (a->x_type) {
-        case xalign_left:   x = 0.0; break;
-        case xalign_middle: x = 0.5; break;
-        case xalign_right:  x = 1.0; break;
-        case xalign_width:  x = 0.0; break;
-        default: break;
-    }
-    switch (a->y_type) {
-        case yalign_top:    y = 0.0; break;
-        case yalign_middle: y = 0.5; break;
-        case yalign_bottom: y = 1.0; break;
-        case yalign_height: y = 0.0; break;
-        default: break;
-    }
-    a->align = alignment(x, x, y, y);
+    verify(coord_scan(a, s->chars), "expected unit-value tokens such as l10 t5");
     return a;
 }
 
@@ -110,8 +150,21 @@ vec2f coord_plot(coord a, rect r, vec2f rel, f32 void_width, f32 void_height) {
     return vec2f(x, y);
 }
 
+/// coord_plot on plain floats; r is x, y, w, h (used by the layout pass, which allocates nothing)
+static inline none coord_plot_f(coord a, f32* r, f32 rel_x, f32 rel_y, f32* px, f32* py) {
+    f32 ax   = a->align ? a->align->x : 0.0f;
+    f32 ay   = a->align ? a->align->y : 0.0f;
+    f32 sc_x = 1.0f - ax * 2.0f;
+    f32 sc_y = 1.0f - ay * 2.0f;
+    f32 ox   = a->x_per ? (a->offset.x * sc_x / 100.0f) * r[2] : a->offset.x * sc_x;
+    f32 oy   = a->y_per ? (a->offset.y * sc_y / 100.0f) * r[3] : a->offset.y * sc_y;
+    *px = a->x_type == xalign_width  ? rel_x + ox : r[0] + r[2] * ax + ox;
+    *py = a->y_type == yalign_height ? rel_y + oy : r[1] + r[3] * ay + oy;
+}
+
 coord coord_with_cstr(coord a, cstr cs) {
-    return coord_with_string(new(coord), string(cs));
+    verify(coord_scan(a, cs), "expected unit-value tokens such as l10 t5");
+    return a;
 }
 
 bool coord_cast_bool(coord a) {
@@ -129,39 +182,38 @@ alignment alignment_with_vec2f(alignment a, vec2f xy) {
     return a;
 }
 
-alignment alignment_with_string(alignment a, string s) {
-    array  ar = split(s, " ");
-    string s0 = ar->elements[0];
-    string s1 = len(ar) > 1 ? ar->elements[1] : ar->elements[0];
-
-    if (is_numeric(s0)) {
-        a->x = real_value(s0);
-    } else {
-        xalign  xa = e_val(xalign, s0->chars);
-        switch (xa) {
-            case xalign_left:   a->x = 0.0; break;
-            case xalign_middle: a->x = 0.5; break; /// todo: needs ability to set a middle in coord/region
-            case xalign_right:  a->x = 1.0; break;
+/// number, or a named side; l/t = 0, m = 0.5, r/b = 1
+static cstr scan_align(cstr p, f32* v) {
+    p = skip_ws(p);
+    if (!*p)
+        return null;
+    if (isalpha(*p)) {
+        switch (*p) {
+            case 'l': case 't': *v = 0.0f; break;
+            case 'm': case 'c': *v = 0.5f; break;
+            case 'r': case 'b': *v = 1.0f; break;
             default: break;
         }
+        while (isalpha(*p)) p++;
+        return p;
     }
+    char* end;
+    f32   n = strtof(p, &end);
+    if (end == p)
+        return null;
+    *v = n;
+    return end;
+}
 
-    if (is_numeric(s1)) {
-        a->y = real_value(s1);
-    } else {
-        yalign  ya = e_val(yalign, s1->chars);
-        switch (ya) {
-            case yalign_top:    a->y = 0.0; break;
-            case yalign_middle: a->y = 0.5; break; /// todo: needs ability to set a middle in coord/region
-            case yalign_bottom: a->y = 1.0; break;
-            default: break;
-        }
-    }
+alignment alignment_with_cstr(alignment a, cstr cs) {
+    cstr p = scan_align(cs, &a->x);
+    if (!p || !scan_align(p, &a->y))
+        a->y = a->x; /// one value applies to both axes
     return a;
 }
 
-alignment alignment_with_cstr(alignment a, cstr cs) {
-    return alignment_with_string(a, string(cs));
+alignment alignment_with_string(alignment a, string s) {
+    return alignment_with_cstr(a, s->chars);
 }
 
 alignment alignment_mix(alignment a, alignment b, f32 f) {
@@ -182,17 +234,16 @@ string region_cast_string(region r) {
 }
 
 region region_with_f32(region reg, f32 f) {
-    reg->tl  = f(coord, "l%f t%f", f, f);
-    A info = head(reg->tl);
-    reg->br  = f(coord, "r%f b%f", f, f);
+    reg->tl  = coord_from(xalign_left,  f, yalign_top,    f, false);
+    reg->br  = coord_from(xalign_right, f, yalign_bottom, f, false);
     reg->set = true;
     return reg;
 }
 
 /// simple rect
 region region_with_rect(region reg, rect r) {
-    reg->tl  = f(coord, "l%f t%f", r->x, r->y);
-    reg->br  = f(coord, "w%f h%f", r->w, r->h);
+    reg->tl  = coord_from(xalign_left,  r->x, yalign_top,    r->y, false);
+    reg->br  = coord_from(xalign_width, r->w, yalign_height, r->h, false);
     reg->set = true;
     return reg;
 }
@@ -209,30 +260,27 @@ region region_with_array(region reg, array corners) {
     return reg;
 }
 
-region region_with_string(region reg, string s) {
-    array a = split(s, " ");
-    if (len(a) == 4) {
-        reg->tl    = f(coord, "%o %o", a->elements[0], a->elements[1]);
-        reg->br    = f(coord, "%o %o", a->elements[2], a->elements[3]);
-    } else if (len(a) == 1) {
-        string f   = first(a);
-        real n     = real_value(f);
-        bool per   = last(f) == '%';
-        reg->tl    = coord(align, alignment(x, 0.0f, y, 0.0f),
-            x_type, xalign_left,
-            y_type, yalign_top,
-            x_per, per, y_per, per);
-        reg->br    = coord(align, alignment(x, 1.0f, y, 1.0f),
-            x_type, xalign_right,
-            y_type, yalign_bottom,
-            y_per, per, y_per, per);
+/// four unit-values (tl then br), or a single inset applied to every side such as 10 or 5%
+region region_with_cstr(region reg, cstr s) {
+    cstr p = skip_ws(s);
+    if (isalpha(*p)) {
+        reg->tl = new(coord);
+        reg->br = new(coord);
+        p = coord_scan(reg->tl, p);
+        verify(p && coord_scan(reg->br, p), "expected four unit-values such as l0 t0 r0 b0");
+    } else {
+        char* end;
+        f32   n   = strtof(p, &end);
+        bool  per = *end == '%';
+        reg->tl   = coord_from(xalign_left,  n, yalign_top,    n, per);
+        reg->br   = coord_from(xalign_right, n, yalign_bottom, n, per);
     }
     reg->set = true;
     return reg;
 }
 
-region region_with_cstr(region a, cstr s) {
-    return region_with_string(new(region), string(s));
+region region_with_string(region reg, string s) {
+    return region_with_cstr(reg, s->chars);
 }
 
 bool region_cast_bool(region a) { return a->set; }
@@ -253,12 +301,644 @@ rect region_rectangle(region data, rect win) {
         plot(data->tl, win, rel, 0, 0), plot(data->br, win, rel, 0, 0));
 }
 
+/// resolve a region within win into out (both x, y, w, h); br plots relative to tl, as relative_rect does
+/// an unset region covers all of win
+static none region_resolve(region reg, f32* win, f32* out) {
+    if (!reg || !reg->set) {
+        memcpy(out, win, sizeof(f32) * 4);
+        return;
+    }
+    f32 x0, y0, x1, y1;
+    coord_plot_f(reg->tl, win, win[0], win[1], &x0, &y0);
+    coord_plot_f(reg->br, win, x0,     y0,     &x1, &y1);
+    out[0] = fminf(x0, x1);
+    out[1] = fminf(y0, y1);
+    out[2] = fabsf(x1 - x0);
+    out[3] = fabsf(y1 - y0);
+}
+
 region region_mix(region data, region b, f32 a) {
     coord m_tl = mix(data->tl, b->tl, a);
     coord m_tr = mix(data->br, b->br, a);
     return region(a(m_tl, m_tr));
 }
 
+/// heap accounting: the composer's C allocations carry a small header naming their subsystem,
+/// and A objects it creates or retires are counted by type size
+typedef struct mem_header {
+    u64 size;
+    u32 subsystem;
+    u32 pad;
+} mem_header;
+
+static mem_stats mem_acct[mem_subsystems];
+
+static cstr mem_names[mem_subsystems] = {
+    "style_parse", "style_cache", "composer_transient", "elements", "transitions", "text" };
+
+static none mem_peak(i64* peak, i64 v) {
+    i64 p = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    while (v > p && !__atomic_compare_exchange_n(peak, &p, v, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) { }
+}
+
+/// counters are atomic since style reloads and compositor threads allocate off the composer thread
+static none mem_add(mem_subsystem ss, i64 bytes, i64 objects) {
+    mem_stats* m = &mem_acct[ss];
+    mem_peak(&m->peak_bytes,   __atomic_add_fetch(&m->bytes,   bytes,   __ATOMIC_RELAXED));
+    mem_peak(&m->peak_objects, __atomic_add_fetch(&m->objects, objects, __ATOMIC_RELAXED));
+}
+
+static none mem_account(mem_subsystem ss, i64 bytes, i64 objects) {
+    mem_add(ss, bytes, objects);
+    if (bytes   > 0) __atomic_add_fetch(&mem_acct[ss].allocs, 1, __ATOMIC_RELAXED);
+    if (bytes   < 0) __atomic_add_fetch(&mem_acct[ss].frees,  1, __ATOMIC_RELAXED);
+}
+
+static void* mem_malloc(mem_subsystem ss, sz size) {
+    mem_header* h = malloc(sizeof(mem_header) + size);
+    h->size      = size;
+    h->subsystem = ss;
+    mem_account(ss, size, 0);
+    return &h[1];
+}
+
+static void* mem_calloc(mem_subsystem ss, sz count, sz size) {
+    void* p = mem_malloc(ss, count * size);
+    memset(p, 0, count * size);
+    return p;
+}
+
+static void* mem_realloc(mem_subsystem ss, void* p, sz size) {
+    if (!p) return mem_malloc(ss, size);
+    mem_header* h = &((mem_header*)p)[-1];
+    i64 prev = h->size;
+    h = realloc(h, sizeof(mem_header) + size);
+    h->size = size;
+    mem_add(h->subsystem, (i64)size - prev, 0);
+    __atomic_add_fetch(&mem_acct[h->subsystem].allocs, 1, __ATOMIC_RELAXED); /// and the block it replaced
+    __atomic_add_fetch(&mem_acct[h->subsystem].frees,  1, __ATOMIC_RELAXED);
+    return &h[1];
+}
+
+static none mem_free(void* p) {
+    if (!p) return;
+    mem_header* h = &((mem_header*)p)[-1];
+    mem_account(h->subsystem, -(i64)h->size, 0);
+    free(h);
+}
+
+static none mem_object(mem_subsystem ss, AType type, i64 count) {
+    mem_add(ss, (i64)type->size * count, count);
+}
+
+mem_stats* ion_mem_stats(mem_subsystem ss) {
+    return &mem_acct[ss];
+}
+
+string ion_mem_report() {
+    char buf[1024];
+    i64  len = 0;
+    for (int i = 0; i < mem_subsystems; i++) {
+        mem_stats* m = &mem_acct[i];
+        len += snprintf(&buf[len], sizeof(buf) - len,
+            "%-20s live %10lld bytes %8lld objects, peak %10lld bytes %8lld objects\n",
+            mem_names[i], (long long)m->bytes, (long long)m->objects,
+            (long long)m->peak_bytes, (long long)m->peak_objects);
+    }
+    return string(chars, buf, ref_length, len);
+}
+
+/// false when composer-owned state outlives its composers (run after the last one is released)
+/// style and text state belong to their own objects and are reported, not checked
+bool ion_mem_check() {
+    mem_subsystem owned[] = { mem_transient, mem_elements, mem_transitions };
+    bool ok = true;
+    for (int i = 0; i < 3; i++)
+        ok &= !mem_acct[owned[i]].bytes && !mem_acct[owned[i]].objects;
+    return ok;
+}
+
+/// epoch reclamation for state read by several composer threads (style snapshots, shared symbol tables)
+/// a reader records the epoch it entered at and never locks; a writer swaps the pointer, then retires
+/// the old block, which is freed once every reader that entered before the swap has left.
+/// each thread that reads holds one reader slot until it exits
+#define EPOCH_READERS 64
+
+typedef struct epoch_retired {
+    u64                   epoch;
+    none                (*free)(handle);
+    handle                ptr;
+    u64*                  owner;    /// when set, only the thread it names frees it (drops A objects,
+                                    /// whose counts are not atomic)
+    struct epoch_retired* next;
+} epoch_retired;
+
+static u64               epoch_now = 1;
+static u64               epoch_reader[EPOCH_READERS]; /// 0 while that reader is outside
+static bool              epoch_claimed[EPOCH_READERS];
+static i32               epoch_readers;              /// high-water mark of claimed slots
+static pthread_key_t     epoch_key;
+static pthread_once_t    epoch_once = PTHREAD_ONCE_INIT;
+static epoch_retired*    epoch_list;
+static pthread_mutex_t   ion_lock = PTHREAD_MUTEX_INITIALIZER; /// writers: publish, symbol and intern inserts
+static _Thread_local i32 epoch_slot = -1;
+static _Thread_local i32 epoch_depth;
+
+/// thread exit gives the slot back, so short-lived threads (compile workers) do not use them up
+static void epoch_release(void* slot) {
+    i32 i = (i32)(intptr_t)slot - 1;
+    __atomic_store_n(&epoch_reader[i], 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&epoch_claimed[i], false, __ATOMIC_RELEASE);
+}
+
+static none epoch_key_init() {
+    pthread_key_create(&epoch_key, epoch_release);
+}
+
+static i32 epoch_claim() {
+    pthread_once(&epoch_once, epoch_key_init);
+    for (i32 i = 0; i < EPOCH_READERS; i++) {
+        bool free_slot = false;
+        if (__atomic_compare_exchange_n(&epoch_claimed[i], &free_slot, true,
+                false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            i32 high = __atomic_load_n(&epoch_readers, __ATOMIC_ACQUIRE);
+            while (high < i + 1 && !__atomic_compare_exchange_n(&epoch_readers, &high, i + 1,
+                    false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+            pthread_setspecific(epoch_key, (void*)(intptr_t)(i + 1));
+            return i;
+        }
+    }
+    verify(false, "too many concurrent reader threads");
+    return -1;
+}
+
+static none epoch_enter() {
+    if (epoch_depth++)
+        return;
+    if (epoch_slot < 0)
+        epoch_slot = epoch_claim();
+    __atomic_store_n(&epoch_reader[epoch_slot],
+        __atomic_load_n(&epoch_now, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+}
+
+static none epoch_exit() {
+    if (--epoch_depth)
+        return;
+    __atomic_store_n(&epoch_reader[epoch_slot], 0, __ATOMIC_RELEASE);
+}
+
+/// frees what no reader can still see, and that this thread may free; ion_lock held
+static none epoch_collect() {
+    u64 oldest = UINT64_MAX;
+    i32 n      = __atomic_load_n(&epoch_readers, __ATOMIC_ACQUIRE);
+    for (i32 i = 0; i < n && i < EPOCH_READERS; i++) {
+        u64 e = __atomic_load_n(&epoch_reader[i], __ATOMIC_SEQ_CST);
+        if (e && e < oldest)
+            oldest = e;
+    }
+    for (epoch_retired** r = &epoch_list; *r; ) {
+        epoch_retired* cur = *r;
+        if (cur->epoch < oldest && (!cur->owner ||
+                pthread_equal((pthread_t)__atomic_load_n(cur->owner, __ATOMIC_ACQUIRE), pthread_self()))) {
+            *r = cur->next;
+            cur->free(cur->ptr);
+            mem_free(cur);
+        } else
+            r = &cur->next;
+    }
+}
+
+/// p must already be unreachable from the shared pointer; ion_lock held
+static none epoch_retire_on(handle p, none (*fn)(handle), u64* owner) {
+    epoch_retired* r = mem_calloc(mem_style_cache, 1, sizeof(epoch_retired));
+    r->owner   = owner;
+    r->epoch   = __atomic_fetch_add(&epoch_now, 1, __ATOMIC_SEQ_CST);
+    r->free    = fn;
+    r->ptr     = p;
+    r->next    = epoch_list;
+    epoch_list = r;
+    epoch_collect();
+}
+
+/// plain memory, freed by whichever thread collects next
+static none epoch_retire(handle p, none (*fn)(handle)) {
+    epoch_retire_on(p, fn, null);
+}
+
+/// frees everything retired under owner now; its object is going away and no reader remains
+static none epoch_retire_all(u64* owner) {
+    pthread_mutex_lock(&ion_lock);
+    for (epoch_retired** r = &epoch_list; *r; ) {
+        epoch_retired* cur = *r;
+        if (cur->owner == owner) {
+            *r = cur->next;
+            cur->free(cur->ptr);
+            mem_free(cur);
+        } else
+            r = &cur->next;
+    }
+    pthread_mutex_unlock(&ion_lock);
+}
+
+/// hash-consed coord, region and alignment values
+/// style and args produce the same few values across hundreds of elements; equal values share
+/// one instance held by this table, so they compare by pointer.  interned values are never mutated
+typedef struct intern_slot {
+    u64    hash;
+    object value;
+} intern_slot;
+
+static intern_slot* interns;
+static i32          intern_count;
+static i32          intern_alloc;
+
+/// past this, values pass through as-is (arbitrary animated args would otherwise grow it forever)
+#define INTERN_LIMIT 65536
+
+static inline u64 intern_mix(u64 h, u64 v) {
+    h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+static inline u64 f32_bits(f32 f) {
+    union { f32 f; u32 u; } b = { .f = f == 0.0f ? 0.0f : f }; /// -0 and 0 are the same value
+    return b.u;
+}
+
+static bool interned_type(AType t) {
+    return t == typeid(alignment) || t == typeid(coord) || t == typeid(region);
+}
+
+static u64 alignment_hash(f32 x, f32 y, bool set) {
+    return intern_mix(intern_mix(intern_mix(1, f32_bits(x)), f32_bits(y)), set);
+}
+
+/// members that hold other interned values are hashed by (canonical) pointer
+static u64 intern_hash(object v) {
+    AType t = isa(v);
+    if (t == typeid(alignment)) {
+        alignment a = v;
+        return alignment_hash(a->x, a->y, a->set);
+    }
+    if (t == typeid(coord)) {
+        coord a = v;
+        u64   h = intern_mix(2, (u64)a->align);
+        h = intern_mix(h, f32_bits(a->offset.x));
+        h = intern_mix(h, f32_bits(a->offset.y));
+        h = intern_mix(h, (u64)a->x_type << 8 | (u64)a->y_type);
+        return intern_mix(h, a->x_rel | a->y_rel << 1 | a->x_per << 2 | a->y_per << 3);
+    }
+    region r = v;
+    return intern_mix(intern_mix(intern_mix(3, (u64)r->tl), (u64)r->br), r->set);
+}
+
+static bool intern_equals(object a, object b) {
+    AType t = isa(a);
+    if (t != isa(b))
+        return false;
+    if (t == typeid(alignment)) {
+        alignment x = a, y = b;
+        return x->x == y->x && x->y == y->y && x->set == y->set;
+    }
+    if (t == typeid(coord)) {
+        coord x = a, y = b;
+        return x->align    == y->align    &&
+               x->offset.x == y->offset.x && x->offset.y == y->offset.y &&
+               x->x_type   == y->x_type   && x->y_type   == y->y_type   &&
+               x->x_rel    == y->x_rel    && x->y_rel    == y->y_rel    &&
+               x->x_per    == y->x_per    && x->y_per    == y->y_per;
+    }
+    region x = a, y = b;
+    return x->tl == y->tl && x->br == y->br && x->set == y->set;
+}
+
+static intern_slot* intern_probe(u64 hash, object v) {
+    i32 mask = intern_alloc - 1;
+    for (i32 i = hash & mask;; i = (i + 1) & mask) {
+        intern_slot* sl = &interns[i];
+        if (!sl->value || (sl->hash == hash && intern_equals(sl->value, v)))
+            return sl;
+    }
+}
+
+static none intern_grow() {
+    intern_slot* prev  = interns;
+    i32          alloc = intern_alloc;
+    intern_alloc = alloc ? alloc << 1 : 1024;
+    interns      = mem_calloc(mem_style_cache, intern_alloc, sizeof(intern_slot));
+    for (i32 i = 0; i < alloc; i++)
+        if (prev[i].value)
+            *intern_probe(prev[i].hash, prev[i].value) = prev[i];
+    mem_free(prev);
+}
+
+static intern_slot* intern_insert(u64 hash, object v) {
+    if ((intern_count + 1) * 2 > intern_alloc)
+        intern_grow();
+    intern_slot* sl = intern_probe(hash, v);
+    if (!sl->value) {
+        sl->hash  = hash;
+        sl->value = hold(v);
+        intern_count++;
+    }
+    return sl;
+}
+
+/// ion_lock held; the table is shared by every composer
+static object intern_resolve(object v);
+
+/// swaps a held member for its canonical instance, moving the reference over
+static object intern_member(object cur) {
+    object canon = intern_resolve(cur);
+    if (canon != cur) {
+        hold(canon);
+        drop(cur);
+    }
+    return canon;
+}
+
+static object intern_resolve(object v) {
+    if (!v || !interned_type(isa(v)))
+        return v;
+    if (isa(v) == typeid(coord)) {
+        coord a = v;
+        a->align = intern_member(a->align); /// swapping in an equal value leaves v unchanged
+    } else if (isa(v) == typeid(region)) {
+        region r = v;
+        r->tl = intern_member(r->tl);
+        r->br = intern_member(r->br);
+    }
+    u64 hash = intern_hash(v);
+    if (!intern_alloc)
+        intern_grow();
+    intern_slot* sl = intern_probe(hash, v);
+    if (sl->value)
+        return sl->value;
+    if (intern_count >= INTERN_LIMIT)
+        return v;
+    return intern_insert(hash, v)->value;
+}
+
+/// canonical instance equal to v (v itself when it is the first of its value)
+static object intern_value(object v) {
+    pthread_mutex_lock(&ion_lock);
+    object r = intern_resolve(v);
+    pthread_mutex_unlock(&ion_lock);
+    return r;
+}
+
+/// canonical values are the ones stored in the table
+static bool interned(object v) {
+    if (!v || !interned_type(isa(v)))
+        return false;
+    pthread_mutex_lock(&ion_lock);
+    bool r = intern_alloc && intern_probe(intern_hash(v), v)->value == v;
+    pthread_mutex_unlock(&ion_lock);
+    return r;
+}
+
+/// alignments are looked up by value first, so coord parsing only allocates unseen ones
+static alignment intern_alignment(f32 x, f32 y, bool set) {
+    u64 hash = alignment_hash(x, y, set);
+    pthread_mutex_lock(&ion_lock);
+    if (intern_alloc) {
+        i32 mask = intern_alloc - 1;
+        for (i32 i = hash & mask; interns[i].value; i = (i + 1) & mask) {
+            alignment a = interns[i].value;
+            if (interns[i].hash == hash && isa(a) == typeid(alignment) &&
+                    a->x == x && a->y == y && a->set == set) {
+                pthread_mutex_unlock(&ion_lock);
+                return a;
+            }
+        }
+    }
+    alignment a = alignment(x, x, y, y, set, set);
+    if (intern_count < INTERN_LIMIT)
+        a = intern_resolve(a);
+    pthread_mutex_unlock(&ion_lock);
+    return a;
+}
+
+/// canonicalize the interned-type props of a freshly mounted instance
+static none intern_props(ion n) {
+    for (AType type = isa(n); type != typeid(ion) && type != typeid(A); type = type->parent_type)
+        for (int m = 0; m < type->member_count; m++) {
+            type_member_t* mem = &type->members[m];
+            if (!(mem->member_type & A_MEMBER_PROP) || !interned_type(mem->type))
+                continue;
+            object* cur = (object*)((cstr)n + mem->offset);
+            object  c   = intern_value(*cur);
+            if (c != *cur) {
+                drop(*cur);
+                *cur = hold(c);
+            }
+        }
+}
+
+/// interned prop symbols
+/// a prop name resolves once to its canonical string: the first member sname registered with that name.
+/// style entries, the member index and transition slots key by that pointer, so lookups hash the address
+/// and never read characters.  snames of other types with the same name are aliases of the symbol.
+/// the alias and type tables are read without locking; they are replaced whole when they grow
+typedef struct sym_pair {
+    object key;
+    object value;
+} sym_pair;
+
+/// open-addressed, pointer-keyed; entries are only added, and the table is freed whole
+typedef struct sym_map {
+    i32           count, alloc;
+    sym_pair*     pairs;
+    mem_subsystem ss;
+} sym_map;
+
+typedef struct sym_slot {
+    u64    hash;
+    string name;
+} sym_slot;
+
+static sym_slot* syms;
+static i32       sym_count;
+static i32       sym_alloc;
+static sym_map*  sym_alias; /// sname or symbol -> symbol
+static sym_map*  sym_types; /// types whose snames are registered
+
+static inline u64 sym_ptr_hash(object p) {
+    u64 h = (u64)(uintptr_t)p;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+}
+
+static sym_pair* sym_probe(sym_map* m, object key) {
+    i32 mask = m->alloc - 1;
+    i32 i    = sym_ptr_hash(key) & mask;
+    for (object k; (k = __atomic_load_n(&m->pairs[i].key, __ATOMIC_ACQUIRE)) && k != key; )
+        i = (i + 1) & mask;
+    return &m->pairs[i];
+}
+
+static object sym_get(sym_map* m, object key) {
+    if (!m || !m->alloc)
+        return null;
+    return sym_probe(m, key)->value;
+}
+
+static none sym_set(sym_map* m, object key, object value) {
+    if ((m->count + 1) * 4 > m->alloc * 3) {
+        sym_map prev = *m;
+        m->alloc = prev.alloc ? prev.alloc << 1 : 16;
+        m->count = prev.count;
+        m->pairs = mem_calloc(m->ss, m->alloc, sizeof(sym_pair));
+        for (i32 i = 0; i < prev.alloc; i++)
+            if (prev.pairs[i].key)
+                *sym_probe(m, prev.pairs[i].key) = prev.pairs[i];
+        mem_free(prev.pairs);
+    }
+    sym_pair* p = sym_probe(m, key);
+    if (!p->key)
+        m->count++;
+    p->key   = key;
+    p->value = value;
+}
+
+static sym_map* sym_map_new(mem_subsystem ss) {
+    sym_map* m = mem_calloc(ss, 1, sizeof(sym_map));
+    m->ss = ss;
+    return m;
+}
+
+static none sym_map_free(sym_map* m) {
+    if (!m) return;
+    mem_free(m->pairs);
+    mem_free(m);
+}
+
+/// readers hold an epoch; the table pointer is loaded once per lookup
+static object sym_get_shared(sym_map** shared, object key) {
+    return sym_get(__atomic_load_n(shared, __ATOMIC_ACQUIRE), key);
+}
+
+/// ion_lock held.  inserts publish the key after its value; growth copies into a new table
+static none sym_set_shared(sym_map** shared, object key, object value) {
+    sym_map* m = *shared;
+    if (!m || (m->count + 1) * 4 > m->alloc * 3) {
+        sym_map* next = sym_map_new(mem_style_cache);
+        next->alloc   = m ? m->alloc << 1 : 64;
+        next->pairs   = mem_calloc(mem_style_cache, next->alloc, sizeof(sym_pair));
+        if (m) {
+            for (i32 i = 0; i < m->alloc; i++)
+                if (m->pairs[i].key)
+                    *sym_probe(next, m->pairs[i].key) = m->pairs[i];
+            next->count = m->count;
+        }
+        __atomic_store_n(shared, next, __ATOMIC_RELEASE);
+        if (m)
+            epoch_retire(m, (none(*)(handle))sym_map_free);
+        m = next;
+    }
+    sym_pair* p = sym_probe(m, key);
+    if (!p->key)
+        m->count++;
+    p->value = value;
+    __atomic_store_n(&p->key, key, __ATOMIC_RELEASE);
+}
+
+static u64 sym_hash(cstr chars, sz len) {
+    u64 h = 0xcbf29ce484222325ull;
+    for (sz i = 0; i < len; i++)
+        h = (h ^ (u8)chars[i]) * 0x100000001b3ull;
+    return h;
+}
+
+static none sym_grow() {
+    sym_slot* prev  = syms;
+    i32       alloc = sym_alloc;
+    sym_alloc = alloc ? alloc << 1 : 256;
+    syms      = mem_calloc(mem_style_cache, sym_alloc, sizeof(sym_slot));
+    i32 mask  = sym_alloc - 1;
+    for (i32 i = 0; i < alloc; i++) {
+        if (!prev[i].name) continue;
+        i32 j = prev[i].hash & mask;
+        while (syms[j].name)
+            j = (j + 1) & mask;
+        syms[j] = prev[i];
+    }
+    mem_free(prev);
+}
+
+/// name becomes the symbol when none exists yet for its characters; ion_lock held
+static string sym_intern(cstr chars, sz len, string name) {
+    if ((sym_count + 1) * 4 > sym_alloc * 3)
+        sym_grow();
+    u64 hash = sym_hash(chars, len);
+    i32 mask = sym_alloc - 1;
+    i32 i    = hash & mask;
+    for (; syms[i].name; i = (i + 1) & mask)
+        if (syms[i].hash == hash && syms[i].name->len == len &&
+                memcmp(syms[i].name->chars, chars, len) == 0)
+            return syms[i].name;
+    syms[i].hash = hash;
+    syms[i].name = hold(name ? name : string(chars, chars, ref_length, len));
+    sym_count++;
+    sym_set_shared(&sym_alias, syms[i].name, syms[i].name);
+    return syms[i].name;
+}
+
+/// canonical symbol for a prop name
+string ion_symbol(cstr chars, sz len) {
+    pthread_mutex_lock(&ion_lock);
+    string sym = sym_intern(chars, len, null);
+    pthread_mutex_unlock(&ion_lock);
+    return sym;
+}
+
+/// symbols and registered snames resolve by address; anything else by its characters
+static string sym_of(string name) {
+    epoch_enter();
+    string sym = sym_get_shared(&sym_alias, name);
+    epoch_exit();
+    return sym ? sym : ion_symbol(name->chars, name->len);
+}
+
+/// registers the prop snames of type and its bases, once per type
+static none sym_seed(AType type) {
+    epoch_enter();
+    bool seeded = sym_get_shared(&sym_types, type) != null;
+    epoch_exit();
+    if (seeded)
+        return;
+    pthread_mutex_lock(&ion_lock);
+    for (; type && type != typeid(A); type = type->parent_type) {
+        if (sym_get(sym_types, type))
+            break;
+        for (int m = 0; m < type->member_count; m++) {
+            type_member_t* mem = &type->members[m];
+            if (!(mem->member_type & A_MEMBER_PROP))
+                continue;
+            string sym = sym_intern(mem->sname->chars, mem->sname->len, mem->sname);
+            if (sym != mem->sname)
+                sym_set_shared(&sym_alias, mem->sname, sym);
+        }
+        sym_set_shared(&sym_types, type, type); /// after its snames, so a lock-free hit sees them
+    }
+    pthread_mutex_unlock(&ion_lock);
+}
+
+/// compiled state of a style: blocks, and the two indexes over them.  immutable once published;
+/// readers load style->state inside an epoch, reload publishes a new one and retires the old
+typedef struct style_state {
+    array    base;          /// style_block
+    map      members;       /// symbol -> blocks
+    sym_map* member_index;  /// symbol -> entries
+    u64      generation;
+} style_state;
+
+static style_state* style_snapshot(style a) {
+    return __atomic_load_n((style_state**)&a->state, __ATOMIC_ACQUIRE);
+}
+
 bool style_qualifier_cast_bool(style_qualifier q) {
     return len(q->type) || q->id || q->state;
 }
@@ -268,7 +948,6 @@ bool style_transition_cast_bool(style_transition a) {
 }
 
 style_transition style_transition_with_string(style_transition a, string s) {
-    print("transition: %o", s);
     array sp = split(s, " ");
     sz    ln = len(sp);
     /// syntax:
@@ -458,8 +1137,9 @@ real style_transition_pos(style_transition a, real tf) {
     return x;
 }
 
-/// to debug style, place conditional breakpoint on member->s_key == "your-prop" (used in a style block) and n->data->id == "id-you-are-debugging"
-/// hopefully we dont have to do this anymore.  its simple and it works.  we may be doing our own style across service component and elemental component but having one system for all is preferred,
+/// to debug style, build with ION_STYLE_TRACE and set trace_style (and trace_id / trace_prop) on the composer;
+/// composer->traces then lists each candidate block's score, the winner and its transition state
+/// we may be doing our own style across service component and elemental component but having one system for all is preferred,
 /// and brings a sense of orthogonality to the react-like pattern, adds type-based contextual grabs and field lookups with prop accessors
 
 style_entry style_best_match(style a, ion n, string prop_name, array entries) {
@@ -471,8 +1151,7 @@ style_entry style_best_match(style a, ion n, string prop_name, array entries) {
         style_block  bl = e->bl;
         real   sc = score(bl, n, true);
         if (sc > 0 && sc >= best_score) {
-            match = get(bl->entries, prop_name);
-            verify(match, "should have matched");
+            match      = e; /// entries come from applicable, one per block for this prop
             best_score = sc;
         }
     }
@@ -516,7 +1195,8 @@ num style_block_score(style_block a, ion n, bool score_state) {
 
             if (q->parent && best_this > 0) {
                 q   = q->parent; // parent qualifier
-                cur = cur->parent ? cur->parent : ion(); // parent ion
+                ion up = live_parent(cur);
+                cur = up ? up : ion(); // parent ion
             } else
                 break;
         }
@@ -525,38 +1205,42 @@ num style_block_score(style_block a, ion n, bool score_state) {
     return best_sc > 0 ? 1.0 : 0.0;
 };
 
-f64 Duration_base_millis(Duration duration) {
+f64 Duration_base_nanos(Duration duration) {
     switch (duration) {
-        case Duration_ns: return 1.0 / 1000.0;
-        case Duration_ms: return 1.0;
-        case Duration_s:  return 1000.0;
+        case Duration_ns: return 1.0;
+        case Duration_ms: return 1000000.0;
+        case Duration_s:  return 1000000000.0;
     }
     return 0.0;
 }
 
-i64 tcoord_get_millis(tcoord a) {
+/// durations stay in nanoseconds so 'ns' units are not truncated away
+i64 tcoord_get_nanos(tcoord a) {
     Duration u = (Duration)(i32)a->enum_v;
-    f64 base = Duration_base_millis(u);
-    return base * a->scale_v;
+    f64 base = Duration_base_nanos(u);
+    return (i64)(base * a->scale_v);
 }
 
+/// result should be unmanaged: the entries pushed are the snapshot's, and are not held
 bool style_applicable(style s, ion n, string prop_name, array result) {
-    array blocks = get(s->members, prop_name); // style free'd?
-    AType type   = isa(n);
-    bool  ret    = false;
+    string prop    = sym_of(prop_name);
+    epoch_enter();
+    style_state* st = style_snapshot(s);
+    array entries = st ? sym_get(st->member_index, prop) : null;
+    AType type    = isa(n);
+    bool  ret     = false;
 
     clear(result);
-    if (blocks)
-        each (blocks, style_block, block) {
-            if (!len(block->types) || index_of(block->types, type) >= 0) {
-                item f = lookup(block->entries, prop_name); // this returns the wrong kind of item reference
-                if (f && score(block, n, false) > 0) {
-                    AType ftype = isa(f->value);
-                    push(result, f->value);
-                    ret = true;
-                }
+    if (entries)
+        each (entries, style_entry, e) {
+            style_block block = e->bl;
+            if ((!len(block->types) || index_of(block->types, type) >= 0) &&
+                    score(block, n, false) > 0) {
+                push(result, e);
+                ret = true;
             }
         }
+    epoch_exit();
     return ret;
 }
 
@@ -569,82 +1253,1378 @@ none  event_clear           (event e) {
     memset(e, 0, sizeof(struct _event));
 }
 
-int ion_compare(ion a, ion b) {
-    AType type = isa(a);
-    if (type != isa(b))
-        return -1;
-    if (a == b)
-        return 0;
-    for (int m = 0; m < type->member_count; m++) {
-        type_member_t* mem = &type->members[m];
-        bool is_prop = mem->member_type & A_MEMBER_PROP;
-        if (!is_prop || strcmp(mem->name, "elements") == 0) continue;
-        if (A_is_inlay(mem)) { // works for structs and primitives
-            ARef cur = (ARef)((cstr)a + mem->offset);
-            ARef nxt = (ARef)((cstr)b + mem->offset);
-            bool is_same = (cur == nxt || 
-                memcmp(cur, nxt, mem->type->size) == 0);
-            if (!is_same)
-                return -1;
-        } else {
-            object* cur = (object*)((cstr)a + mem->offset);
-            object* nxt = (object*)((cstr)b + mem->offset);
-            if (*cur != *nxt) {
-                bool is_same = (*cur && *nxt) ? 
-                    compare(*cur, *nxt) == 0 : false;
-                if (!is_same)
-                    return -1;
-            }
+/// text storage: a persistent treap of pieces over one append-only buffer
+/// pieces are immutable once built; edits copy the O(log n) path they touch, so a
+/// snapshot of the document is a held root pointer, and undo never copies text
+typedef struct text_buf {
+    char*   chars;
+    i64     len, alloc;
+    i64*    nl;                 /// buffer offsets of every '\n', ascending
+    i64     nl_count, nl_alloc;
+    i32     refs;
+} text_buf;
+
+typedef struct piece {
+    struct piece* l;
+    struct piece* r;
+    i32     refs;
+    u32     prio;
+    i64     start, len;         /// span within the buffer
+    i64     lines;              /// '\n' within the span
+    i64     sum_len, sum_lines; /// subtree totals
+} piece;
+
+static _Thread_local u32 piece_seed = 2463534242u; /// texts are edited on composer and task threads
+
+static u32 piece_prio() {
+    piece_seed ^= piece_seed << 13;
+    piece_seed ^= piece_seed >> 17;
+    piece_seed ^= piece_seed << 5;
+    return piece_seed;
+}
+
+/// index of the first newline at or after buffer offset pos
+static i64 nl_lower(text_buf* b, i64 pos) {
+    i64 lo = 0, hi = b->nl_count;
+    while (lo < hi) {
+        i64 m = (lo + hi) >> 1;
+        if (b->nl[m] < pos) lo = m + 1;
+        else                hi = m;
+    }
+    return lo;
+}
+
+static i64 nl_between(text_buf* b, i64 start, i64 len) {
+    return nl_lower(b, start + len) - nl_lower(b, start);
+}
+
+static i64 text_buf_append(text_buf* b, const char* s, i64 len) {
+    i64 start = b->len;
+    if (b->len + len + 1 > b->alloc) {
+        i64 alloc = b->alloc ? b->alloc : 4096;
+        while (alloc < b->len + len + 1) alloc <<= 1;
+        b->chars = mem_realloc(mem_text, b->chars, alloc);
+        b->alloc = alloc;
+    }
+    memcpy(&b->chars[b->len], s, len);
+    for (i64 i = 0; i < len; i++) {
+        if (s[i] != '\n') continue;
+        if (b->nl_count == b->nl_alloc) {
+            b->nl_alloc = b->nl_alloc ? b->nl_alloc << 1 : 1024;
+            b->nl       = mem_realloc(mem_text, b->nl, sizeof(i64) * b->nl_alloc);
         }
+        b->nl[b->nl_count++] = start + i;
     }
-    return 0;
+    b->len += len;
+    b->chars[b->len] = 0;
+    return start;
 }
 
-none ion_mount(ion a, list props) {
+static none text_buf_drop(text_buf* b) {
+    if (b && --b->refs == 0) {
+        mem_free(b->chars);
+        mem_free(b->nl);
+        mem_free(b);
+    }
 }
 
-none ion_umount(ion a) {
+static inline i64 piece_len  (piece* t) { return t ? t->sum_len   : 0; }
+static inline i64 piece_lines(piece* t) { return t ? t->sum_lines : 0; }
+
+static piece* piece_hold(piece* t) {
+    if (t) t->refs++;
+    return t;
 }
 
-map ion_render(ion a, list changed) {
-    return a->elements; /// elements is not allocated for non-container elements, so default behavior is to not host components
+static none piece_drop(piece* t) {
+    while (t && --t->refs == 0) {
+        piece* r = t->r;
+        piece_drop(t->l);
+        mem_free(t);
+        t = r; /// right spine iteratively; the treap keeps the left recursion shallow
+    }
 }
 
-none ion_init(ion a) {
+/// new node over a span with the given children (held)
+static piece* piece_new(i64 start, i64 len, i64 lines, u32 prio, piece* l, piece* r) {
+    piece* t     = mem_calloc(mem_text, 1, sizeof(piece));
+    t->refs      = 1;
+    t->prio      = prio;
+    t->start     = start;
+    t->len       = len;
+    t->lines     = lines;
+    t->l         = piece_hold(l);
+    t->r         = piece_hold(r);
+    t->sum_len   = piece_len(l)   + len   + piece_len(r);
+    t->sum_lines = piece_lines(l) + lines + piece_lines(r);
+    return t;
 }
 
+static piece* piece_with(piece* t, piece* l, piece* r) {
+    return piece_new(t->start, t->len, t->lines, t->prio, l, r);
+}
 
-style style_with_path(style a, path css_path) {
-    if (!exists(css_path)) {
-        int test = 0;
-        test++;
+/// inputs are borrowed, outputs owned; nothing reachable from t is modified
+static none piece_split(text_buf* b, piece* t, i64 pos, piece** pa, piece** pb) {
+    if (!t) {
+        *pa = *pb = null;
+        return;
     }
-    verify(exists(css_path), "css path does not exist");
-    string style_str = read(css_path, typeid(string));
-    a->base    = array(alloc, 32);
+    i64 ll = piece_len(t->l);
+    if (pos <= ll) {
+        piece *x, *y;
+        piece_split(b, t->l, pos, &x, &y);
+        *pa = x;
+        *pb = piece_with(t, y, t->r);
+        piece_drop(y);
+    } else if (pos >= ll + t->len) {
+        piece *x, *y;
+        piece_split(b, t->r, pos - ll - t->len, &x, &y);
+        *pa = piece_with(t, t->l, x);
+        *pb = y;
+        piece_drop(x);
+    } else {
+        /// split inside this span; both halves keep the priority, so heap order holds
+        i64 off    = pos - ll;
+        i64 lines  = nl_between(b, t->start, off);
+        *pa = piece_new(t->start,       off,          lines,            t->prio, t->l, null);
+        *pb = piece_new(t->start + off, t->len - off, t->lines - lines, t->prio, null, t->r);
+    }
+}
+
+static piece* piece_merge(piece* x, piece* y) {
+    if (!x) return piece_hold(y);
+    if (!y) return piece_hold(x);
+    piece* res;
+    if (x->prio > y->prio) {
+        piece* r = piece_merge(x->r, y);
+        res = piece_with(x, x->l, r);
+        piece_drop(r);
+    } else {
+        piece* l = piece_merge(x, y->l);
+        res = piece_with(y, l, y->r);
+        piece_drop(l);
+    }
+    return res;
+}
+
+/// returns a new root with [pos, pos + del) replaced by s; root is left intact
+static piece* piece_replace(text_buf* b, piece* root, i64 pos, i64 del, const char* s, i64 len) {
+    piece *a, *rest, *mid, *c;
+    piece_split(b, root, pos, &a, &rest);
+    piece_split(b, rest, del, &mid, &c);
+    piece_drop(rest);
+    piece_drop(mid);
+    piece* res;
+    if (len > 0) {
+        i64    start = text_buf_append(b, s, len);
+        piece* ins   = piece_new(start, len, nl_between(b, start, len), piece_prio(), null, null);
+        piece* left  = piece_merge(a, ins);
+        res = piece_merge(left, c);
+        piece_drop(ins);
+        piece_drop(left);
+    } else
+        res = piece_merge(a, c);
+    piece_drop(a);
+    piece_drop(c);
+    return res;
+}
+
+/// document offset of the k-th newline (0-based), or -1
+static i64 piece_nl_offset(text_buf* b, piece* t, i64 k) {
+    i64 base = 0;
+    while (t) {
+        i64 ll = piece_lines(t->l);
+        if (k < ll) {
+            t = t->l;
+            continue;
+        }
+        k -= ll;
+        i64 ls = piece_len(t->l);
+        if (k < t->lines)
+            return base + ls + b->nl[nl_lower(b, t->start) + k] - t->start;
+        k    -= t->lines;
+        base += ls + t->len;
+        t     = t->r;
+    }
+    return -1;
+}
+
+/// newlines before document offset pos
+static i64 piece_lines_before(text_buf* b, piece* t, i64 pos) {
+    i64 lines = 0;
+    while (t && pos > 0) {
+        i64 ll = piece_len(t->l);
+        if (pos <= ll) {
+            t = t->l;
+            continue;
+        }
+        lines += piece_lines(t->l);
+        pos   -= ll;
+        if (pos <= t->len)
+            return lines + nl_between(b, t->start, pos);
+        lines += t->lines;
+        pos   -= t->len;
+        t      = t->r;
+    }
+    return lines;
+}
+
+/// copy [pos, pos + len) of the document into out
+static none piece_read(text_buf* b, piece* t, i64 pos, i64 len, char* out) {
+    while (t && len > 0) {
+        i64 ll = piece_len(t->l);
+        if (pos < ll) {
+            i64 n = ll - pos < len ? ll - pos : len;
+            piece_read(b, t->l, pos, n, out);
+            out += n;
+            len -= n;
+            pos  = ll;
+        }
+        if (len <= 0)
+            break;
+        i64 off = pos - ll;
+        if (off < t->len) {
+            i64 n = t->len - off < len ? t->len - off : len;
+            memcpy(out, &b->chars[t->start + off], n);
+            out += n;
+            len -= n;
+            pos += n;
+        }
+        pos -= ll + t->len;
+        t    = t->r;
+    }
+}
+
+/// glyph advances are supplied by the host (the composer has no rasterizer of its own) and cached per font
+/// lines store them as prefix sums: adv[i] is the x of column i, adv[len] the line width.
+/// caches hold their font, so a freed font's address never matches, and the least recent goes
+/// once there are GLYPH_CACHES of them (or on text_font_evict)
+#define GLYPH_CACHES 32
+
+static glyph_advance advance_fn;
+static font_height   height_fn;
+
+typedef struct glyph_cache {
+    font    f;
+    f64     ascii[128];
+    u8      known[128];
+    u32*    keys;               /// open addressing for everything past ascii; 0 is empty
+    f64*    widths;
+    i32     count, alloc;
+} glyph_cache;
+
+static glyph_cache** glyph_caches;
+static i32           glyph_cache_count;
+static glyph_cache*  glyph_last;
+static pthread_mutex_t glyph_lock = PTHREAD_MUTEX_INITIALIZER; /// composers measure on their own threads
+
+none text_metrics(glyph_advance advance, font_height height) {
+    advance_fn = advance;
+    height_fn  = height;
+}
+
+static none glyph_cache_free(glyph_cache* c) {
+    if (glyph_last == c)
+        glyph_last = null;
+    drop(c->f);
+    mem_free(c->keys);
+    mem_free(c->widths);
+    mem_free(c);
+}
+
+/// most recently used first
+static glyph_cache* glyph_cache_for(font f) {
+    if (glyph_last && glyph_last->f == f)
+        return glyph_last;
+    i32 i = 0;
+    while (i < glyph_cache_count && glyph_caches[i]->f != f)
+        i++;
+    glyph_cache* c;
+    if (i < glyph_cache_count)
+        c = glyph_caches[i];
+    else {
+        if (!glyph_caches)
+            glyph_caches = mem_calloc(mem_text, GLYPH_CACHES, sizeof(glyph_cache*));
+        if (glyph_cache_count == GLYPH_CACHES)
+            glyph_cache_free(glyph_caches[--glyph_cache_count]);
+        c    = mem_calloc(mem_text, 1, sizeof(glyph_cache));
+        c->f = hold(f);
+        i    = glyph_cache_count++;
+    }
+    memmove(&glyph_caches[1], &glyph_caches[0], sizeof(glyph_cache*) * i);
+    glyph_caches[0] = c;
+    return glyph_last = c;
+}
+
+static f64 glyph_measure(font f, u32 cp) {
+    return advance_fn ? advance_fn(f, cp) : 0.0;
+}
+
+static f64 glyph_width(font f, u32 cp) {
+    glyph_cache* c = glyph_cache_for(f);
+    if (cp < 128) {
+        if (!c->known[cp]) {
+            c->ascii[cp] = glyph_measure(f, cp);
+            c->known[cp] = 1;
+        }
+        return c->ascii[cp];
+    }
+    if ((c->count + 1) * 2 > c->alloc) {
+        i32  alloc  = c->alloc ? c->alloc << 1 : 256;
+        u32* keys   = mem_calloc(mem_text, alloc, sizeof(u32));
+        f64* widths = mem_calloc(mem_text, alloc, sizeof(f64));
+        for (i32 i = 0; i < c->alloc; i++) {
+            if (!c->keys[i]) continue;
+            i32 j = c->keys[i] & (alloc - 1);
+            while (keys[j]) j = (j + 1) & (alloc - 1);
+            keys[j]   = c->keys[i];
+            widths[j] = c->widths[i];
+        }
+        mem_free(c->keys);
+        mem_free(c->widths);
+        c->keys   = keys;
+        c->widths = widths;
+        c->alloc  = alloc;
+    }
+    i32 j = (cp * 2654435761u) & (c->alloc - 1);
+    for (; c->keys[j]; j = (j + 1) & (c->alloc - 1))
+        if (c->keys[j] == cp)
+            return c->widths[j];
+    c->keys[j]   = cp;
+    c->widths[j] = glyph_measure(f, cp);
+    c->count++;
+    return c->widths[j];
+}
+
+/// the lead byte of a utf-8 sequence carries the glyph's advance, continuation bytes none
+/// takes glyph_lock once per run of text rather than per glyph
+static none advance_fill(font f, f64* adv, const char* chars, i64 len) {
+    f64 x = adv[0];
+    pthread_mutex_lock(&glyph_lock);
+    for (i64 i = 0; i < len;) {
+        u8  c  = (u8)chars[i];
+        i32 n  = c < 0x80 ? 1 : c < 0xe0 ? 2 : c < 0xf0 ? 3 : 4;
+        u32 cp = n == 1 ? c : c & (0xff >> (n + 1));
+        for (i32 k = 1; k < n && i + k < len; k++)
+            cp = cp << 6 | ((u8)chars[i + k] & 0x3f);
+        x += glyph_width(f, cp);
+        for (i32 k = 0; k < n && i < len; k++)
+            adv[++i] = x;
+    }
+    pthread_mutex_unlock(&glyph_lock);
+}
+
+/// columns [col, col + removed) become chars[0, added); only the inserted span is measured,
+/// the suffix is shifted by the change in width
+static f64* advance_edit(font f, f64* adv, i64 len, i64 col, i64 removed, const char* chars, i64 added) {
+    i64 nlen  = len - removed + added;
+    f64 old_w = adv[col + removed] - adv[col];
+    i64 tail  = len - (col + removed) + 1;
+    if (nlen > len)
+        adv = mem_realloc(mem_text, adv, sizeof(f64) * (nlen + 1));
+    memmove(&adv[col + added], &adv[col + removed], sizeof(f64) * tail);
+    f64 after = adv[col + added];   /// old x at the start of the tail
+    advance_fill(f, &adv[col], chars, added);
+    f64 delta = adv[col + added] - adv[col] - old_w;
+    adv[col + added] = after + delta;
+    for (i64 i = col + added + 1; i <= nlen; i++)
+        adv[i] += delta;
+    return adv;
+}
+
+/// measure the whole line with f, unless it already is; returns the line width
+f64 line_info_measure(line_info l, font f) {
+    if (!l->adv || l->adv_font != f) {
+        mem_free(l->adv);
+        l->adv      = mem_calloc(mem_text, l->len + 1, sizeof(f64));
+        if (l->adv_font != f) {
+            if (l->adv_font) drop(l->adv_font);
+            l->adv_font = hold(f); /// held, so a freed font's address never matches
+        }
+        advance_fill(f, l->adv, l->data->chars, l->len);
+    }
+    return ((f64*)l->adv)[l->len];
+}
+
+f64 line_info_x_at(line_info l, num column) {
+    verify(l->adv, "line is not measured");
+    return ((f64*)l->adv)[clamp(column, 0, l->len)];
+}
+
+/// nearest caret column to x; binary search over the prefix sums
+num line_info_column_at(line_info l, f64 x) {
+    verify(l->adv, "line is not measured");
+    f64* adv = l->adv;
+    i64  lo  = 0, hi = l->len;
+    while (lo < hi) {
+        i64 m = (lo + hi + 1) >> 1;
+        if (adv[m] <= x) lo = m;
+        else             hi = m - 1;
+    }
+    /// round to the closer edge, then off any utf-8 continuation byte
+    i64 col = lo;
+    if (col < l->len) {
+        i64 next = col + 1;
+        while (next < l->len && ((u8)l->data->chars[next] & 0xc0) == 0x80) next++;
+        if (x - adv[col] > adv[next] - x) col = next;
+    }
+    while (col > 0 && col < l->len && ((u8)l->data->chars[col] & 0xc0) == 0x80) col--;
+    return col;
+}
+
+none line_info_dealloc(line_info l) {
+    mem_free(l->adv);
+    l->adv = null;
+}
+
+/// single-row edit on a materialized line; measured advances are updated for the edited span only
+static none line_info_edit(line_info l, i64 col, i64 removed, cstr chars, i64 added, string data) {
+    if (l->adv)
+        l->adv = advance_edit(l->adv_font, l->adv, l->len, col, removed, chars, added);
+    drop(l->data);
+    l->data = hold(data);
+    l->len  = data->len;
+}
+
+/// fenwick tree over row heights (1-based, n + 1 entries): y of a row and row at a y in O(log n)
+static none fenwick_build(f64* t, f64* h, i64 n) {
+    t[0] = 0;
+    for (i64 i = 1; i <= n; i++)
+        t[i] = h[i - 1];
+    for (i64 i = 1; i <= n; i++) {
+        i64 j = i + (i & -i);
+        if (j <= n) t[j] += t[i];
+    }
+}
+
+static none fenwick_add(f64* t, i64 n, i64 row, f64 v) {
+    for (i64 i = row + 1; i <= n; i += i & -i)
+        t[i] += v;
+}
+
+/// sum of heights of rows [0, row)
+static f64 fenwick_sum(f64* t, i64 row) {
+    f64 s = 0;
+    for (i64 i = row; i > 0; i -= i & -i)
+        s += t[i];
+    return s;
+}
+
+/// row containing y (rows before it sum to <= y), clamped to the last row
+static i64 fenwick_find(f64* t, i64 n, f64 y) {
+    i64 pos  = 0;
+    i64 step = 1;
+    while (step << 1 <= n) step <<= 1;
+    for (; step; step >>= 1)
+        if (pos + step <= n && t[pos + step] <= y) {
+            pos += step;
+            y   -= t[pos];
+        }
+    return pos < n ? pos : n - 1;
+}
+
+/// line_info per row, materialized on demand and spliced on edit (rows are never all measured up front)
+/// heights index the document vertically; rows not yet measured count as one estimated line (-1 here)
+typedef struct text_rows {
+    line_info* rows;
+    f64*       heights;
+    f64*       tree;            /// fenwick over heights, count + 1 entries
+    bool       tree_dirty;
+    f64        estimate;
+    font       f;               /// held, so a released font's address can't come back as a match
+    f64        wrap;
+    i64        count, alloc;
+} text_rows;
+
+static text_buf* text_store(text a) {
+    if (!a->buf) {
+        text_buf* b = mem_calloc(mem_text, 1, sizeof(text_buf));
+        b->refs = 1;
+        a->buf  = b;
+    }
+    return a->buf;
+}
+
+static none text_rows_reset(text a) {
+    text_rows* r = a->rows;
+    if (!r) return;
+    for (i64 i = 0; i < r->count; i++)
+        drop(r->rows[i]);
+    mem_free(r->rows);
+    mem_free(r->heights);
+    mem_free(r->tree);
+    drop(r->f);
+    mem_free(r);
+    a->rows = null;
+}
+
+static none text_rows_unmeasure(text_rows* r) {
+    for (i64 i = 0; i < r->count; i++)
+        r->heights[i] = -1;
+    r->tree_dirty = true;
+}
+
+static text_rows* text_rows_get(text a) {
+    text_rows* r = a->rows;
+    if (!r) {
+        a->rows    = r = mem_calloc(mem_text, 1, sizeof(text_rows));
+        r->count   = line_count(a);
+        r->alloc   = r->count;
+        r->rows    = mem_calloc(mem_text, r->alloc,     sizeof(line_info));
+        r->heights = mem_calloc(mem_text, r->alloc,     sizeof(f64));
+        r->tree    = mem_calloc(mem_text, r->alloc + 1, sizeof(f64));
+        text_rows_unmeasure(r);
+    }
+    return r;
+}
+
+static none text_rows_index(text_rows* r) {
+    for (i64 i = 0; i < r->count; i++)
+        r->tree[i + 1] = r->heights[i] < 0 ? r->estimate : r->heights[i];
+    fenwick_build(r->tree, &r->tree[1], r->count);
+    r->tree_dirty = false;
+}
+
+/// replace rows [row, row + removed) with 'added' unmaterialized rows
+static none text_rows_splice(text a, i64 row, i64 removed, i64 added) {
+    text_rows* r = a->rows;
+    if (!r) return;
+    for (i64 i = row; i < row + removed; i++)
+        drop(r->rows[i]);
+    i64 count = r->count - removed + added;
+    if (count > r->alloc) {
+        r->alloc   = count << 1;
+        r->rows    = mem_realloc(mem_text, r->rows,    sizeof(line_info) * r->alloc);
+        r->heights = mem_realloc(mem_text, r->heights, sizeof(f64)       * r->alloc);
+        r->tree    = mem_realloc(mem_text, r->tree,    sizeof(f64)       * (r->alloc + 1));
+    }
+    i64 tail = r->count - row - removed;
+    memmove(&r->rows   [row + added], &r->rows   [row + removed], sizeof(line_info) * tail);
+    memmove(&r->heights[row + added], &r->heights[row + removed], sizeof(f64)       * tail);
+    memset (&r->rows   [row], 0, sizeof(line_info) * added);
+    for (i64 i = row; i < row + added; i++)
+        r->heights[i] = -1;
+    r->count      = count;
+    r->tree_dirty = true;
+}
+
+static i64 text_line_start(text a, i64 row) {
+    if (row <= 0) return 0;
+    i64 o = piece_nl_offset(a->buf, a->root, row - 1);
+    return o < 0 ? piece_len(a->root) : o + 1;
+}
+
+/// offset of the newline ending row, or the end of the document
+static i64 text_line_end(text a, i64 row) {
+    i64 o = piece_nl_offset(a->buf, a->root, row);
+    return o < 0 ? piece_len(a->root) : o;
+}
+
+static string text_read(text a, i64 pos, i64 len) {
+    char*  chars = mem_malloc(mem_text, len + 1);
+    piece_read(a->buf, a->root, pos, len, chars);
+    string res   = string(chars, chars, ref_length, len);
+    mem_free(chars);
+    return res;
+}
+
+text text_with_string(text a, string s) {
+    text_buf* b = text_store(a);
+    if (s->len) {
+        i64 start = text_buf_append(b, s->chars, s->len);
+        a->root   = piece_new(start, s->len, nl_between(b, start, s->len), piece_prio(), null, null);
+    }
+    return a;
+}
+
+num text_line_count(text a) { return piece_lines(a->root) + 1; }
+num text_char_count(text a) { return piece_len(a->root); }
+
+/// column is clamped to the row's length
+num text_offset(text a, text_sel sel) {
+    i64 start = text_line_start(a, sel->row);
+    i64 end   = text_line_end(a, sel->row);
+    return start + clamp(sel->column, 0, end - start);
+}
+
+none text_position(text a, num offset, text_sel sel) {
+    sel->row    = piece_lines_before(a->buf, a->root, offset);
+    sel->column = offset - text_line_start(a, sel->row);
+}
+
+line_info text_line(text a, num row) {
+    verify(row >= 0 && row < line_count(a), "row out of range");
+    text_rows* r = text_rows_get(a);
+    line_info  l = r->rows[row];
+    if (!l) {
+        i64 start = text_line_start(a, row);
+        i64 len   = text_line_end(a, row) - start;
+        l = r->rows[row] = hold(line_info(data, text_read(a, start, len), len, len));
+    }
+    return l;
+}
+
+string text_extract(text a, text_sel from, text_sel to) {
+    i64 o0 = offset(a, from);
+    i64 o1 = offset(a, to);
+    return o0 <= o1 ? text_read(a, o0, o1 - o0) : text_read(a, o1, o0 - o1);
+}
+
+/// undo journal: each op is the text removed and inserted at a row/column, so undo and redo
+/// are replace calls of their own and never copy the document.  ops [0, cursor) undo, [cursor, count) redo
+typedef struct text_op {
+    i64   row, column;
+    i64   removed, inserted;
+    i64   time;
+    char* chars;                /// removed bytes, then inserted bytes
+} text_op;
+
+typedef struct text_journal {
+    text_op* ops;
+    i64      count, alloc, cursor;
+    i64      bytes;
+    bool     replaying;
+} text_journal;
+
+/// typing and deleting within this long of the last edit merge into one op
+#define JOURNAL_MERGE_NANOS 1000000000ll
+#define JOURNAL_LIMIT       (1024 * 1024)
+
+static i64 monotonic_nanos();
+
+static none text_op_free(text_journal* j, text_op* op) {
+    j->bytes -= sizeof(text_op) + op->removed + op->inserted;
+    mem_free(op->chars);
+}
+
+static none text_journal_trim(text_journal* j, i64 limit) {
+    for (i64 i = j->cursor; i < j->count; i++)
+        text_op_free(j, &j->ops[i]);
+    j->count = j->cursor;
+    i64 evict = 0;
+    while (evict < j->count && j->bytes > limit)
+        text_op_free(j, &j->ops[evict++]);
+    if (evict) {
+        memmove(j->ops, &j->ops[evict], sizeof(text_op) * (j->count - evict));
+        j->count  -= evict;
+        j->cursor -= evict;
+    }
+}
+
+static bool has_nl(cstr chars, i64 len) {
+    return len && memchr(chars, '\n', len) != null;
+}
+
+/// called by replace before it edits; removed is [o0, o1) at row r0
+static none text_record(text a, i64 r0, i64 o0, i64 o1, string s) {
+    text_journal* j = a->journal;
+    if (a->history_limit < 0 || (j && j->replaying))
+        return;
+    if (!j)
+        a->journal = j = mem_calloc(mem_text, 1, sizeof(text_journal));
+    i64    limit    = a->history_limit ? a->history_limit : JOURNAL_LIMIT;
+    i64    col      = o0 - text_line_start(a, r0);
+    i64    removed  = o1 - o0;
+    i64    inserted = s ? s->len : 0;
+    if (!removed && !inserted)
+        return;
+    string rm       = removed ? text_read(a, o0, removed) : null;
+    i64    t        = monotonic_nanos();
+
+    text_journal_trim(j, limit); /// a new edit drops what could be redone
+    text_op* last = j->count ? &j->ops[j->count - 1] : null;
+    if (last && t - last->time < JOURNAL_MERGE_NANOS) {
+        bool typing   = !removed && !last->removed && inserted && !has_nl(s->chars, inserted) &&
+                        last->row == r0 && last->column + last->inserted == col;
+        bool backward = !inserted && !last->inserted && rm && !has_nl(rm->chars, removed) &&
+                        last->row == r0 && col + removed == last->column;
+        bool forward  = !inserted && !last->inserted && rm && !has_nl(rm->chars, removed) &&
+                        last->row == r0 && col == last->column;
+        if (typing || backward || forward) {
+            i64 add = inserted + removed;
+            last->chars = mem_realloc(mem_text, last->chars, last->removed + last->inserted + add);
+            if (typing)
+                memcpy(&last->chars[last->removed + last->inserted], s->chars, inserted);
+            else if (forward)
+                memcpy(&last->chars[last->removed], rm->chars, removed);
+            else {
+                memmove(&last->chars[removed], last->chars, last->removed);
+                memcpy(last->chars, rm->chars, removed);
+                last->column = col;
+            }
+            last->inserted += inserted;
+            last->removed  += removed;
+            last->time      = t;
+            j->bytes       += add;
+            text_journal_trim(j, limit);
+            return;
+        }
+    }
+    if (j->count == j->alloc) {
+        j->alloc = j->alloc ? j->alloc << 1 : 32;
+        j->ops   = mem_realloc(mem_text, j->ops, sizeof(text_op) * j->alloc);
+    }
+    text_op* op = &j->ops[j->count++];
+    *op = (text_op) {
+        .row = r0, .column = col, .removed = removed, .inserted = inserted, .time = t,
+        .chars = mem_malloc(mem_text, removed + inserted + 1) };
+    if (removed)  memcpy(op->chars, rm->chars, removed);
+    if (inserted) memcpy(&op->chars[removed], s->chars, inserted);
+    j->cursor  = j->count;
+    j->bytes  += sizeof(text_op) + removed + inserted;
+    text_journal_trim(j, limit);
+}
+
+/// replaces the op's span of cur bytes with its other side; caret lands at the end of what was put back
+static none text_journal_apply(text a, text_op* op, i64 cur, cstr chars, i64 len, text_sel caret) {
+    text_journal* j    = a->journal;
+    text_sel      from = text_sel(row, op->row, column, op->column);
+    text_sel      to   = new(text_sel);
+    position(a, offset(a, from) + cur, to);
+    j->replaying = true;
+    replace(a, from, to, string(chars, chars, ref_length, len));
+    j->replaying = false;
+    if (caret) {
+        caret->row    = from->row;
+        caret->column = from->column;
+    }
+    op->time = 0; /// nothing merges into an op that was undone or redone
+}
+
+bool text_undo(text a, text_sel caret) {
+    text_journal* j = a->journal;
+    if (!j || !j->cursor)
+        return false;
+    text_op* op = &j->ops[--j->cursor];
+    text_journal_apply(a, op, op->inserted, op->chars, op->removed, caret);
+    return true;
+}
+
+bool text_redo(text a, text_sel caret) {
+    text_journal* j = a->journal;
+    if (!j || j->cursor == j->count)
+        return false;
+    text_op* op = &j->ops[j->cursor++];
+    text_journal_apply(a, op, op->removed, &op->chars[op->removed], op->inserted, caret);
+    return true;
+}
+
+none text_clear_history(text a) {
+    text_journal* j = a->journal;
+    if (!j) return;
+    j->cursor = 0;
+    text_journal_trim(j, 0);
+    mem_free(j->ops);
+    mem_free(j);
+    a->journal = null;
+}
+
+/// replace the selection with s; both ends of the selection move to the end of the inserted text
+/// O(log n) in the document, plus the inserted length
+none text_replace(text a, text_sel from, text_sel to, string s) {
+    text_buf* b   = text_store(a);
+    i64       o0  = offset(a, from);
+    i64       o1  = offset(a, to);
+    if (o1 < o0) { i64 t = o0; o0 = o1; o1 = t; }
+    i64       r0  = piece_lines_before(b, a->root, o0);
+    i64       r1  = piece_lines_before(b, a->root, o1);
+    i64       len = s ? s->len : 0;
+    i64       nl  = 0;
+    for (i64 i = 0; i < len; i++)
+        nl += s->chars[i] == '\n';
+
+    text_record(a, r0, o0, o1, s);
+
+    text_rows* rows   = a->rows;
+    line_info  edited = (rows && r0 == r1 && !nl) ? rows->rows[r0] : null;
+
+    piece* root = piece_replace(b, a->root, o0, o1 - o0, len ? s->chars : "", len);
+    piece_drop(a->root);
+    a->root = root;
+    if (edited) {
+        /// typing within a line keeps its line_info, and its measure
+        i64 start = text_line_start(a, r0);
+        line_info_edit(edited, o0 - start, o1 - o0, len ? s->chars : "", len,
+            text_read(a, start, text_line_end(a, r0) - start));
+        if (rows->heights[r0] >= 0) {
+            if (!rows->tree_dirty)
+                fenwick_add(rows->tree, rows->count, r0, rows->estimate - rows->heights[r0]);
+            rows->heights[r0] = -1; /// wrapping may have changed; measured again when visible
+        }
+    } else
+        text_rows_splice(a, r0, r1 - r0 + 1, nl + 1);
+
+    position(a, o0 + len, from);
+    to->row    = from->row;
+    to->column = from->column;
+}
+
+/// shares the buffer and holds the current root; O(1), and later edits do not affect it
+text text_snapshot(text a) {
+    text_buf* b    = text_store(a);
+    text      snap = new(text);
+    b->refs++;
+    snap->buf  = b;
+    snap->root = piece_hold(a->root);
+    return snap;
+}
+
+none text_restore(text a, text snap) {
+    verify(snap->buf == text_store(a), "snapshot is from another text");
+    piece* prev = a->root;
+    a->root = piece_hold(snap->root);
+    piece_drop(prev);
+    text_rows_reset(a);
+    clear_history(a); /// recorded rows and columns refer to the replaced document
+}
+
+/// rows need some height to virtualize; used when the host gives none (no font_height registered)
+#define TEXT_LINE_FALLBACK 16.0
+
+/// virtualized layout: only rows intersecting [top, bottom) are materialized and measured;
+/// the rest count as one line_height in the height index.  wrap > 0 estimates wrapped rows by width
+/// returns the document height, for scrolling
+f64 text_layout(text a, font f, f64 line_height, f64 wrap, f64 top, f64 bottom) {
+    text_rows* r = text_rows_get(a);
+    if (!(line_height > 0))
+        line_height = TEXT_LINE_FALLBACK; /// zero-height rows would all fall inside [top, bottom)
+    if (r->f != f || r->wrap != wrap) {
+        if (r->f != f) {
+            drop(r->f);
+            r->f = hold(f);
+        }
+        r->wrap = wrap;
+        text_rows_unmeasure(r);
+    }
+    if (r->estimate != line_height) {
+        r->estimate   = line_height;
+        r->tree_dirty = true;
+    }
+    if (r->tree_dirty)
+        text_rows_index(r);
+
+    i64 row = fenwick_find(r->tree, r->count, top);
+    f64 y   = fenwick_sum(r->tree, row);
+    a->view_first = row;
+    for (; row < r->count && y < bottom; row++) {
+        line_info l = text_line(a, row);
+        f64       w = measure(l, f);
+        f64       h = r->heights[row];
+        if (h < 0) {
+            i64 wraps = wrap > 0 ? (i64)ceil(w / wrap) : 1;
+            h = line_height * (wraps > 1 ? wraps : 1);
+            fenwick_add(r->tree, r->count, row, h - line_height);
+            r->heights[row] = h;
+        }
+        if (!l->bounds)
+            l->bounds = hold(rect(x, 0.0f, y, (f32)y, w, (f32)w, h, (f32)h));
+        else {
+            l->bounds->y = y;
+            l->bounds->w = w;
+            l->bounds->h = h;
+        }
+        y += h;
+    }
+    a->view_count = row - a->view_first;
+    return fenwick_sum(r->tree, r->count);
+}
+
+num text_row_at(text a, f64 y) {
+    text_rows* r = text_rows_get(a);
+    if (r->tree_dirty)
+        text_rows_index(r);
+    return fenwick_find(r->tree, r->count, y);
+}
+
+f64 text_row_y(text a, num row) {
+    text_rows* r = text_rows_get(a);
+    if (r->tree_dirty)
+        text_rows_index(r);
+    return fenwick_sum(r->tree, clamp(row, 0, r->count));
+}
+
+none text_dealloc(text a) {
+    text_rows_reset(a);
+    clear_history(a);
+    piece_drop(a->root);
+    text_buf_drop(a->buf);
+    a->root = null;
+    a->buf  = null;
+}
+
+/// shaped labels, least recently used first out once bytes passes limit
+/// a static label costs one hash of its content per layout pass.  each composer has its own cache
+/// (in its slot table), used only by the thread composing for it, so entries never cross threads
+typedef struct shape_entry {
+    u64                 hash;
+    string              content;
+    font                f;
+    f32                 scale;
+    f64                 width, height, line_height;
+    xalign              ax;
+    yalign              ay;
+    bool                ellipsis;
+    text_shape          shape;
+    struct shape_entry* prev;       /// lru order, most recent at head
+    struct shape_entry* next;
+    struct shape_entry* chain;      /// bucket
+} shape_entry;
+
+typedef struct shape_cache {
+    shape_entry** buckets;
+    i64           bucket_count;
+    i64           count;
+    shape_entry*  head;
+    shape_entry*  tail;
+    i64           bytes;
+    i64           limit;
+} shape_cache;
+
+static u64 shape_hash(string content, font f, f32 scale, f64 width, f64 height, f64 lh,
+        xalign ax, yalign ay, bool ellipsis) {
+    u64 h = 0xcbf29ce484222325ull;
+    for (i64 i = 0; i < content->len; i++)
+        h = (h ^ (u8)content->chars[i]) * 0x100000001b3ull;
+    h = intern_mix(h, (u64)(uintptr_t)f);
+    h = intern_mix(h, f32_bits(scale));
+    h = intern_mix(h, f32_bits((f32)width));
+    h = intern_mix(h, f32_bits((f32)height));
+    h = intern_mix(h, f32_bits((f32)lh));
+    return intern_mix(h, ((u64)ax << 16) | ((u64)ay << 8) | ellipsis);
+}
+
+static none shape_unlink(shape_cache* c, shape_entry* e) {
+    if (e->prev) e->prev->next = e->next; else c->head = e->next;
+    if (e->next) e->next->prev = e->prev; else c->tail = e->prev;
+    e->prev = e->next = null;
+}
+
+static none shape_front(shape_cache* c, shape_entry* e) {
+    e->next = c->head;
+    if (c->head) c->head->prev = e;
+    c->head = e;
+    if (!c->tail) c->tail = e;
+}
+
+static none shape_evict(shape_cache* c, shape_entry* e) {
+    shape_entry** b = &c->buckets[e->hash & (c->bucket_count - 1)];
+    while (*b != e) b = &(*b)->chain;
+    *b = e->chain;
+    shape_unlink(c, e);
+    c->bytes -= e->shape->bytes;
+    c->count--;
+    drop(e->content);
+    drop(e->f);
+    drop(e->shape);
+    mem_free(e);
+}
+
+static none shape_grow(shape_cache* c) {
+    i64           prev_count = c->bucket_count;
+    shape_entry** prev       = c->buckets;
+    c->bucket_count = prev_count ? prev_count << 1 : 256;
+    c->buckets      = mem_calloc(mem_text, c->bucket_count, sizeof(shape_entry*));
+    for (i64 i = 0; i < prev_count; i++)
+        for (shape_entry* e = prev[i], *n; e; e = n) {
+            n = e->chain;
+            shape_entry** b = &c->buckets[e->hash & (c->bucket_count - 1)];
+            e->chain = *b;
+            *b       = e;
+        }
+    mem_free(prev);
+}
+
+shape_cache* shape_cache_new() {
+    shape_cache* c = mem_calloc(mem_text, 1, sizeof(shape_cache));
+    c->limit = 4 * 1024 * 1024;
+    return c;
+}
+
+none shape_cache_free(shape_cache* c) {
+    if (!c) return;
+    while (c->tail)
+        shape_evict(c, c->tail);
+    mem_free(c->buckets);
+    mem_free(c);
+}
+
+/// evicts down to bytes; 0 clears the cache
+none shape_budget(shape_cache* c, i64 bytes) {
+    c->limit = bytes;
+    while (c->tail && c->bytes > c->limit)
+        shape_evict(c, c->tail);
+}
+
+none shape_font_evict(shape_cache* c, font f) {
+    for (shape_entry* e = c->head, *n; e; e = n) {
+        n = e->next;
+        if (e->f == f)
+            shape_evict(c, e);
+    }
+}
+
+none text_font_evict(font f) {
+    pthread_mutex_lock(&glyph_lock);
+    for (i32 i = 0; i < glyph_cache_count; i++)
+        if (glyph_caches[i]->f == f) {
+            glyph_cache_free(glyph_caches[i]);
+            memmove(&glyph_caches[i], &glyph_caches[i + 1],
+                sizeof(glyph_cache*) * (glyph_cache_count - i - 1));
+            glyph_cache_count--;
+            break;
+        }
+    pthread_mutex_unlock(&glyph_lock);
+}
+
+static line_info shape_line(cstr chars, i64 len, font f) {
+    line_info l = line_info(data, string(chars, chars, ref_length, len), len, len);
+    measure(l, f);
+    return l;
+}
+
+/// last column whose x fits within limit, on a utf-8 boundary
+static i64 shape_fit(line_info l, f64 limit) {
+    i64 col = column_at(l, limit);
+    while (col > 0 && x_at(l, col) > limit) {
+        col--;
+        while (col > 0 && ((u8)l->data->chars[col] & 0xc0) == 0x80) col--;
+    }
+    return col;
+}
+
+static text_shape shape_build(string content, font f, f32 scale, f64 width, f64 height, f64 lh,
+        xalign ax, yalign ay, bool ellipsis) {
+    text_shape s     = text_shape(lines, array(alloc, 4), cut, -1);
+    cstr       chars = content->chars;
+    i64        n     = content->len;
+    f64        k     = scale > 0 ? scale : 1.0;
+    f64        limit = width / k;   /// measured in unscaled advances
+    f64        dots  = 0;
+    if (ellipsis) {
+        line_info d = shape_line("...", 3, f);
+        dots = measure(d, f);
+        drop(d);
+    }
+    for (i64 start = 0; start <= n; ) {
+        i64 end = start;
+        while (end < n && chars[end] != '\n') end++;
+        i64 pos = start;
+        do {
+            line_info l = shape_line(&chars[pos], end - pos, f);
+            i64       take;
+            if (width <= 0 || measure(l, f) <= limit) {
+                take = end - pos;
+            } else if (ellipsis) {
+                i64 col = shape_fit(l, limit - dots);
+                drop(l);
+                char* cut = mem_malloc(mem_text, col + 3);
+                memcpy(cut, &chars[pos], col);
+                memcpy(&cut[col], "...", 3);
+                l = shape_line(cut, col + 3, f);
+                mem_free(cut);
+                if (s->cut < 0) s->cut = pos + col;
+                take = end - pos;
+            } else {
+                /// break after the last space that fits, otherwise mid-word (at least one glyph)
+                i64 col = shape_fit(l, limit);
+                i64 brk = col;
+                while (brk > 0 && chars[pos + brk] != ' ') brk--;
+                if (brk > 0) col = brk;
+                else if (col == 0) {
+                    col = 1;
+                    while (col < end - pos && ((u8)chars[pos + col] & 0xc0) == 0x80) col++;
+                }
+                drop(l);
+                l    = shape_line(&chars[pos], col, f);
+                take = col;
+                while (pos + take < end && chars[pos + take] == ' ') take++;
+            }
+            push(s->lines, l);
+            s->bytes += typeid(line_info)->size + (l->len + 1) * (sizeof(f64) + 1);
+            pos += take;
+        } while (pos < end);
+        start = end + 1;
+    }
+
+    /// placement within the text rect (0, 0, width, height)
+    i64 count = len(s->lines);
+    f64 th    = lh * count;
+    f64 y     = ay == yalign_middle ? (height - th) / 2 :
+                ay == yalign_bottom ? (height - th) : 0;
+    each(s->lines, line_info, l) {
+        f64 lw = measure(l, f) * k;
+        f64 x  = ax == xalign_middle ? (width - lw) / 2 :
+                 ax == xalign_right  ? (width - lw) : 0;
+        l->placement = hold(rect(x, (f32)x, y, (f32)y, w, (f32)lw, h, (f32)lh));
+        s->width     = max(s->width, lw);
+        y           += lh;
+    }
+    s->height = th;
+    s->bytes += sizeof(shape_entry) + content->len;
+    return s;
+}
+
+text_shape shape_text(shape_cache* c, string content, font f, f32 scale, f64 width, f64 height, f64 lh,
+        xalign ax, yalign ay, bool ellipsis) {
+    u64 hash = shape_hash(content, f, scale, width, height, lh, ax, ay, ellipsis);
+    if (c->bucket_count)
+        for (shape_entry* e = c->buckets[hash & (c->bucket_count - 1)]; e; e = e->chain)
+            if (e->hash == hash && e->f == f && e->scale == scale && e->width == width &&
+                e->height == height && e->line_height == lh && e->ax == ax && e->ay == ay &&
+                e->ellipsis == ellipsis && e->content->len == content->len &&
+                memcmp(e->content->chars, content->chars, content->len) == 0) {
+                if (e != c->head) {
+                    shape_unlink(c, e);
+                    shape_front(c, e);
+                }
+                return e->shape;
+            }
+
+    text_shape s = shape_build(content, f, scale, width, height, lh, ax, ay, ellipsis);
+    if (s->bytes > c->limit)
+        return s; /// uncached; the caller holds it
+    if (c->count + 1 > c->bucket_count * 3 / 4)
+        shape_grow(c);
+    shape_entry* e = mem_calloc(mem_text, 1, sizeof(shape_entry));
+    *e = (shape_entry) {
+        .hash = hash, .content = hold(content), .f = hold(f), .scale = scale, .width = width,
+        .height = height, .line_height = lh, .ax = ax, .ay = ay, .ellipsis = ellipsis,
+        .shape = hold(s) };
+    shape_entry** b = &c->buckets[hash & (c->bucket_count - 1)];
+    e->chain = *b;
+    *b       = e;
+    shape_front(c, e);
+    c->count++;
+    c->bytes += s->bytes;
+    while (c->bytes > c->limit && c->tail != e)
+        shape_evict(c, c->tail);
+    return s;
+}
+
+int ion_compare(ion a, ion b) {
+    AType type = isa(a);
+    if (type != isa(b))
+        return -1;
+    if (a == b)
+        return 0;
+    for (int m = 0; m < type->member_count; m++) {
+        type_member_t* mem = &type->members[m];
+        bool is_prop = mem->member_type & A_MEMBER_PROP;
+        if (!is_prop || strcmp(mem->name, "elements") == 0) continue;
+        if (A_is_inlay(mem)) { // works for structs and primitives
+            ARef cur = (ARef)((cstr)a + mem->offset);
+            ARef nxt = (ARef)((cstr)b + mem->offset);
+            bool is_same = (cur == nxt || 
+                memcmp(cur, nxt, mem->type->size) == 0);
+            if (!is_same)
+                return -1;
+        } else {
+            object* cur = (object*)((cstr)a + mem->offset);
+            object* nxt = (object*)((cstr)b + mem->offset);
+            if (*cur != *nxt) {
+                /// two distinct canonical values are different values
+                bool is_same = (*cur && *nxt) && !(interned(*cur) && interned(*nxt)) ?
+                    compare(*cur, *nxt) == 0 : false;
+                if (!is_same)
+                    return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+none ion_mount(ion a, list props) {
+}
+
+none ion_umount(ion a) {
+}
+
+map ion_render(ion a, list changed) {
+    return a->elements; /// elements is not allocated for non-container elements, so default behavior is to not host components
+}
+
+none ion_init(ion a) {
+}
+
+/// subclasses return the element for a row; null skips it
+element list_view_item(list_view a, num index) {
+    return null;
+}
+
+static f32 list_view_item_height(list_view a) {
+    return a->item_height > 0 ? a->item_height : 24.0f;
+}
+
+map list_view_render(list_view a, list changed) {
+    f32 ih    = list_view_item_height(a);
+    i32 over  = a->overscan > 0 ? a->overscan : 4;
+    f32 view  = a->child_bounds ? a->child_bounds->h : ih * 32; /// before the first layout
+    num first = max(0, (num)floorf(a->scroll.y / ih) - over);
+    num last  = min(a->item_count, (num)ceilf((a->scroll.y + view) / ih) + over);
+    /// window only changes with the viewport size; rows keep their key while they stay in it
+    a->window         = (num)ceilf(view / ih) + 2 * over + 1;
+    a->first          = first;
+    a->content_height = ih * a->item_count;
+
+    map rows = map(hsize, 64);
+    for (num i = first; i < last; i++) {
+        element e = item(a, i);
+        if (e)
+            set(rows, f(string, "row-%i", (int)(i % a->window)), e);
+    }
+    return rows;
+}
+
+/// window for a list_view row: one item_height tall at its index, under the scroll offset
+static none list_view_row(list_view a, ion row, f32* win, f32* out) {
+    num key   = row->id ? atoll(&row->id->chars[4]) : 0;
+    num w     = a->window > 0 ? a->window : 1;
+    num index = a->first + ((key - a->first % w) % w + w) % w;
+    f32 ih    = list_view_item_height(a);
+    out[0] = win[0];
+    out[1] = win[1] + ih * index - a->scroll.y;
+    out[2] = win[2];
+    out[3] = ih;
+}
+
+
+static style_state* style_compile(string code, string* error);
+static none         style_publish(style a, style_state* st);
+static none         style_state_free(style_state* st);
+static none         style_report(style a, string error);
+static i64          style_blocks(array base);
+static none         style_decode_block(style_block bl);
+
+style style_with_path(style a, path css_path) {
+    verify(exists(css_path), "css path does not exist");
+    string style_str = read(css_path, typeid(string));
     if (css_path != a->css_path) {
         a->css_path = css_path;
     }
-    a->mod_time = modified_time(css_path);
-    a->members = map(hsize, 32);
-    process(a, style_str);
-    cache_members(a);
+    __atomic_store_n(&a->mod_time, modified_time(css_path), __ATOMIC_RELEASE);
+    process(a, style_str); /// publishes; readers on the previous state are unaffected
     a->loaded   = true;
     a->reloaded = true; /// cache validation for composer user
     return a;
 }
 
+/// background reload: a worker reads the file into plain C memory and leaves it in a->pending.
+/// parsing builds A objects (and touches shared symbols and interned values), so it runs in
+/// adopt, on the owner thread; the worker holds and drops nothing
+typedef struct style_source {
+    style     owner;            /// weak; only its atomic pending and compiling are written
+    pthread_t thread;
+    bool      joinable;
+    char*     path;
+    char*     chars;
+    i64       len;
+    bool      missing;
+} style_source;
+
+static pthread_mutex_t style_read_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  style_read_done = PTHREAD_COND_INITIALIZER; /// a read finished
+
+static none style_source_free(style_source* src) {
+    if (src->joinable)
+        pthread_join(src->thread, null); /// it has published; this only waits for it to return
+    mem_free(src->path);
+    mem_free(src->chars);
+    mem_free(src);
+}
+
+static void* style_read_main(void* arg) {
+    style_source* src = arg;
+    style         a   = src->owner;
+    FILE*         f   = fopen(src->path, "rb");
+    if (!f)
+        src->missing = true;
+    else {
+        fseek(f, 0, SEEK_END);
+        long n = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        src->chars = mem_malloc(mem_style_parse, n > 0 ? n + 1 : 1);
+        src->len   = n > 0 ? (i64)fread(src->chars, 1, n, f) : 0;
+        src->chars[src->len] = 0;
+        fclose(f);
+    }
+    /// check_reload starts no read while a result waits, so the slot is empty here
+    pthread_mutex_lock(&style_read_lock);
+    __atomic_store_n((style_source**)&a->pending, src, __ATOMIC_RELEASE);
+    __atomic_store_n(&a->compiling, false, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&style_read_done);
+    pthread_mutex_unlock(&style_read_lock);
+    return null;
+}
+
+/// starts a read on a worker thread when the file changed; never blocks on the file.
+/// several composers may poll one style, only one read runs at a time
 bool style_check_reload(style a) {
     verify(a->css_path, "style not loaded with path");
     i64 m = modified_time(a->css_path);
-    if (a->mod_time != m) {
-        a->mod_time  = m;
-        //drop(a->members);
-        //drop(a->base);
-        style_with_path(a, a->css_path);
-        return true;
+    if (__atomic_load_n(&a->mod_time, __ATOMIC_ACQUIRE) == m)
+        return false;
+    bool idle = false;
+    if (!__atomic_compare_exchange_n(&a->compiling, &idle, true,
+            false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        return false; /// a change during the read is picked up once it finishes
+    if (__atomic_load_n(&a->pending, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&a->compiling, false, __ATOMIC_RELEASE);
+        return false; /// the owner adopts the waiting result first; the change is seen next check
     }
-    return false;
+    __atomic_store_n(&a->mod_time, m, __ATOMIC_RELEASE);
+    cstr          path = cstring(a->css_path);
+    sz            plen = strlen(path);
+    style_source* src  = mem_calloc(mem_style_parse, 1, sizeof(style_source));
+    src->owner    = a;
+    src->path     = mem_malloc(mem_style_parse, plen + 1);
+    memcpy(src->path, path, plen + 1);
+    src->joinable = true;   /// joined by whoever frees it, after it has published
+    if (pthread_create(&src->thread, null, style_read_main, src) != 0) {
+        src->joinable = false;
+        style_read_main(src); /// no thread available; read here rather than miss the change
+    }
+    return true;
+}
+
+/// parses and publishes a finished background read; called by composers at the frame boundary.
+/// a failed compile is reported and the running state kept
+/// only the style's owner thread adopts and frees retired states: the one that loaded it, or the
+/// first to adopt after style_handoff; composers on other threads follow through the generation
+bool style_adopt(style a) {
+    u64 none_yet = 0;
+    __atomic_compare_exchange_n(&a->owner, &none_yet, (u64)pthread_self(),
+        false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    if (!pthread_equal((pthread_t)a->owner, pthread_self()))
+        return false;
+    if (epoch_list) {
+        pthread_mutex_lock(&ion_lock);
+        epoch_collect();
+        pthread_mutex_unlock(&ion_lock);
+    }
+    if (!__atomic_load_n(&a->pending, __ATOMIC_ACQUIRE))
+        return false;
+    style_source* src   = __atomic_exchange_n((style_source**)&a->pending, null, __ATOMIC_ACQ_REL);
+    string        error = null;
+    style_state*  st    = null;
+    if (src->missing)
+        error = hold(f(string, "file not found"));
+    else
+        st = style_compile(string(chars, src->chars, ref_length, src->len), &error);
+    style_source_free(src);
+    style_report(a, error);
+    if (!st)
+        return false;
+    style_publish(a, st);
+    a->reloaded = true;
+    return true;
+}
+
+/// gives up ownership held by thread, so the next thread to adopt takes it over
+/// (a composer moving onto or off its composing thread)
+static none style_handoff(style a, pthread_t thread) {
+    u64 cur = (u64)thread;
+    __atomic_compare_exchange_n(&a->owner, &cur, 0, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
 }
 
 none style_watch_reload(style a, array css, ARef arg) {
@@ -704,7 +2684,32 @@ static bool scan_to(cstr* p_cursor, string chars) {
     return false;
 }
 
-static list parse_qualifiers(style_block bl, cstr *p) {
+/// first syntax error of a compile, as line:column: message; parsing stops there
+typedef struct style_parse {
+    cstr   code;
+    string error;
+} style_parse;
+
+static bool parse_fail(style_parse* ps, cstr at, cstr fmt, ...) {
+    i32 line = 1, col = 1;
+    for (cstr c = ps->code; at && c < at && *c; c++) {
+        if (*c == '\n') { line++; col = 1; }
+        else col++;
+    }
+    char    msg[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, args);
+    va_end(args);
+    if (!ps->error)
+        ps->error = f(string, "%i:%i: %s", line, col, msg);
+    return false;
+}
+
+#define parse_expect(ps, cond, at, ...) \
+    if (!(cond)) return parse_fail(ps, at, __VA_ARGS__)
+
+static list parse_qualifiers(style_parse* ps, style_block bl, cstr *p) {
     string   qstr;
     cstr start = *p;
     cstr end   = null;
@@ -771,7 +2776,11 @@ static list parse_qualifiers(style_block bl, cstr *p) {
             }
             if (v->type) { /// todo: verify idata is correctly registered and looked up
                 v->ty = A_find_type(v->type->chars);
-                verify(v->ty, "type must exist");
+                if (!v->ty) {
+                    parse_fail(ps, start, "unknown type %s", v->type->chars);
+                    drop(ops);
+                    return null;
+                }
                 if (index_of(bl->types, v->ty) == -1)
                     push(bl->types, v->ty);
             }
@@ -803,38 +2812,74 @@ static list parse_qualifiers(style_block bl, cstr *p) {
 }
 
 /// compute available entries for props on a Element
-map style_compute(style a, ion n) {
-    map avail = map(hsize, 16);
+static none style_avail_add(style_avail* avail, string prop, array entries) {
+    if (avail->count == avail->alloc) {
+        avail->alloc   = avail->alloc ? avail->alloc << 1 : 16;
+        avail->props   = mem_realloc(mem_transient, avail->props,   sizeof(string) * avail->alloc);
+        avail->entries = mem_realloc(mem_transient, avail->entries, sizeof(array)  * avail->alloc);
+    }
+    avail->props  [avail->count] = prop;
+    avail->entries[avail->count] = hold(entries); /// the array is ours; what it lists is not
+    avail->count++;
+    sym_set(avail->index, prop, (object)(uintptr_t)avail->count);
+}
+
+static array style_avail_get(style_avail* avail, string prop) {
+    i64 i = avail ? (i64)(uintptr_t)sym_get(avail->index, prop) : 0;
+    return i ? avail->entries[i - 1] : null;
+}
+
+none style_avail_free(style_avail* avail) {
+    if (!avail) return;
+    for (i32 i = 0; i < avail->count; i++)
+        drop(avail->entries[i]);
+    sym_map_free(avail->index);
+    mem_free(avail->props);
+    mem_free(avail->entries);
+    mem_free(avail);
+}
+
+/// a style_avail (see lib/ion); nothing the snapshot owns is held, so composers may compute
+/// on several threads at once
+handle style_compute(style a, ion n) {
+    style_avail* avail = mem_calloc(mem_transient, 1, sizeof(style_avail));
+    avail->index = sym_map_new(mem_transient);
     AType ty = isa(n);
     verify(instanceof(n, ion), "must inherit ion");
+    sym_seed(ty);
+    epoch_enter(); /// entries stay valid across applicable calls, even if a reload publishes meanwhile
+    array all = array(alloc, 32, unmanaged, true);
     while (ty != typeid(ion)) {
-        array all = array(alloc, 32);
         for (int m = 0; m < ty->member_count; m++) {
             type_member_t* mem = &ty->members[m];
             if (mem->member_type != A_MEMBER_PROP)
                 continue;
-            AType sname_type = isa(mem->sname);
-            A sname_header = A_header(mem->sname);
-            string name = mem->sname;
+            string name = sym_of(mem->sname);
             if (applicable(a, n, name, all)) {
-                set(avail, name, all);
-                all = array(alloc, 32);
+                style_avail_add(avail, name, all);
+                all = array(alloc, 32, unmanaged, true);
             }
         }
         ty = ty->parent_type;
     }
+    epoch_exit();
     return avail;
 }
 
-static void cache_b(style a, style_block bl) {
+static void cache_b(style_state* st, style_block bl) {
     pairs (bl->entries, i) {
-        string      key = i->key;
         style_entry e   = i->value;
         bool  found = false;
-        array cache = get(a->members, e->member);
+        array index = sym_get(st->member_index, e->member);
+        if (!index) {
+            index = hold(array(alloc, 8));
+            sym_set(st->member_index, e->member, index);
+        }
+        push(index, e);
+        array cache = get(st->members, e->member);
         if (!cache) {
              cache = array();
-             set(a->members, e->member, cache);
+             set(st->members, e->member, cache);
         }
         each (cache, style_block, cb)
             found |= cb == bl;
@@ -843,13 +2888,81 @@ static void cache_b(style a, style_block bl) {
             push(cache, bl);
     }
     each (bl->blocks, style_block, s)
-        cache_b(a, s);
+        cache_b(st, s);
 }
 
+
+/// members maps each symbol to its blocks; member_index to the entries themselves, keyed by address
+static style_state* style_state_new(array base) {
+    style_state* st  = mem_calloc(mem_style_cache, 1, sizeof(style_state));
+    st->base         = hold(base);
+    st->members      = hold(map(hsize, 32));
+    st->member_index = sym_map_new(mem_style_cache);
+    each (base, style_block, b)
+        cache_b(st, b);
+    return st;
+}
+
+static none style_state_free(style_state* st) {
+    sym_map* m = st->member_index;
+    for (i32 i = 0; i < m->alloc; i++)
+        if (m->pairs[i].key)
+            drop(m->pairs[i].value);
+    sym_map_free(m);
+    drop(st->members);
+    drop(st->base);
+    mem_free(st);
+}
+
+/// swaps in st; readers still on the previous state keep it until they leave their epoch.
+/// base and members mirror the latest state for inspection from the publishing thread
+static none style_publish(style a, style_state* st) {
+    u64 none_yet = 0;
+    __atomic_compare_exchange_n(&a->owner, &none_yet, (u64)pthread_self(),
+        false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    verify(pthread_equal((pthread_t)a->owner, pthread_self()), "style published off its owner thread");
+    each (st->base, style_block, b)
+        style_decode_block(b); /// holds shared interned values, so not on the compile worker
+    pthread_mutex_lock(&ion_lock);
+    style_state* prev = __atomic_exchange_n((style_state**)&a->state, st, __ATOMIC_ACQ_REL);
+    st->generation    = prev ? prev->generation + 1 : 1;
+    __atomic_store_n(&a->generation, st->generation, __ATOMIC_RELEASE);
+    if (a->base != st->base) {
+        if (a->base) {
+            mem_object(mem_style_parse, typeid(style_block), -style_blocks(a->base));
+            drop(a->base);
+        }
+        a->base = hold(st->base);
+    }
+    if (a->members) drop(a->members);
+    a->members = hold(st->members);
+    if (prev)
+        epoch_retire_on(prev, (none(*)(handle))style_state_free, &a->owner);
+    pthread_mutex_unlock(&ion_lock);
+}
+
+/// publishes a state re-indexed from the current base (process already indexes what it parses)
 void style_cache_members(style a) {
     if (a->base)
-        each (a->base, style_block, b)
-            cache_b(a, b);
+        style_publish(a, style_state_new(a->base));
+}
+
+/// no reader can remain once the style itself is released; a running compile is waited for
+none style_dealloc(style a) {
+    pthread_mutex_lock(&style_read_lock);
+    while (__atomic_load_n(&a->compiling, __ATOMIC_ACQUIRE))
+        pthread_cond_wait(&style_read_done, &style_read_lock);
+    pthread_mutex_unlock(&style_read_lock);
+    epoch_retire_all(&a->owner);
+    if (a->pending)
+        style_source_free(a->pending);
+    a->pending = null;
+    style_state* st = style_snapshot(a);
+    if (st) {
+        mem_object(mem_style_parse, typeid(style_block), -style_blocks(st->base));
+        style_state_free(st);
+    }
+    a->state = null;
 }
 
 /// \\ = \ ... \x = \x
@@ -882,11 +2995,17 @@ static string parse_quoted(cstr *cursor, size_t max_len) {
 }
 
 
-none parse_block(style_block bl, cstr* p_sc) {
+/// false on the first syntax error (in ps->error); blocks parsed so far are discarded with the compile
+static bool parse_block(style_parse* ps, style_block bl, cstr* p_sc) {
     cstr sc = *p_sc;
     ws(&sc);
-    verify(*sc == '.' || isalpha(*sc), "expected Type[.id], or .id");
-    bl->quals = hold(parse_qualifiers(bl, &sc));
+    parse_expect(ps, *sc == '.' || isalpha(*sc), sc, "expected Type[.id], or .id");
+    bl->quals = hold(parse_qualifiers(ps, bl, &sc));
+    if (ps->error)
+        return false;
+    parse_expect(ps, *sc == '{', sc, "expected {");
+    each (bl->types, AType, t)
+        sym_seed(t); /// member names below resolve to these types' snames
     sc++;
     ws(&sc);
     ///
@@ -894,32 +3013,34 @@ none parse_block(style_block bl, cstr* p_sc) {
         /// read up to ;, {, or }
         ws(&sc);
         cstr start = sc;
-        verify(scan_to(&sc, string(";{}")), "expected member expression or qualifier");
+        parse_expect(ps, scan_to(&sc, string(";{}")), start, "expected member expression or qualifier");
         if (*sc == '{') {
             ///
             style_block bl_n = style_block(types, array(unmanaged, true));
             push(bl->blocks, bl_n);
             bl_n->parent = bl;
-            /// parse sub-block
+            /// parse sub-block from its qualifiers; it consumes its own closing brace
             sc = start;
-            parse_block(bl_n, sc);
-            verify(*sc == '}', "expected }");
-            sc++;
+            if (!parse_block(ps, bl_n, &sc))
+                return false;
             ws(&sc);
             ///
         } else if (*sc == ';') {
             /// read member
             cstr cur = start;
-            verify(scan_to(&cur, string(":")) && (cur < sc), "expected [member:]value;");
-            string  member = string(chars, start, ref_length, distance(start, cur));
-            for (int i = 0; i < member->len; i++)
-                if (member->chars[i] == '-') (*(cstr)&member->chars[i]) = '_';
+            parse_expect(ps, scan_to(&cur, string(":")) && (cur < sc), start, "expected [member:]value;");
+            sz      mlen = distance(start, cur);
+            char    mbuf[128];
+            parse_expect(ps, mlen < sizeof(mbuf), start, "member name too long");
+            for (sz i = 0; i < mlen; i++)
+                mbuf[i] = start[i] == '-' ? '_' : start[i];
+            string  member = ion_symbol(mbuf, mlen);
             cur++;
             ws(&cur);
 
             /// read value
             cstr vstart = cur;
-            verify(scan_to(&cur, string(";")), "expected member:[value;]");
+            parse_expect(ps, scan_to(&cur, string(";")), vstart, "expected member:[value;]");
             
             /// needs escape sequencing?
             size_t len      = distance(vstart, cur);
@@ -939,8 +3060,8 @@ none parse_block(style_block bl, cstr* p_sc) {
             style_transition trans = param ? style_transition(param) : null;
             
             /// check
-            verify(member, "member cannot be blank");
-            verify(value,  "value cannot be blank");
+            parse_expect(ps, mlen,       start,  "member cannot be blank");
+            parse_expect(ps, len(value), vstart, "value cannot be blank");
             style_entry e = style_entry(
                 member, member, value, value, trans, trans, bl, bl);
             set(bl->entries, member, e);
@@ -949,19 +3070,95 @@ none parse_block(style_block bl, cstr* p_sc) {
             ws(&sc);
         }
     }
-    verify(!*sc || *sc == '}', "expected closed-brace");
-    if (*sc == '}')
-        sc++;
+    parse_expect(ps, *sc == '}', sc, "expected closed-brace");
+    sc++;
     *p_sc = sc;
+    return true;
 }
 
-void style_process(style a, string code) {
-    a->base = array(alloc, 32);
-    for (cstr sc = cstring(code); sc && *sc; ws(&sc)) {
+static i64 style_block_count(style_block bl) {
+    i64 n = 1;
+    each (bl->blocks, style_block, s)
+        n += style_block_count(s);
+    return n;
+}
+
+static i64 style_blocks(array base) {
+    i64 n = 0;
+    if (base)
+        each (base, style_block, b)
+            n += style_block_count(b);
+    return n;
+}
+
+/// value of an entry as the member's type; shared by every element the entry applies to
+static object style_decode(type_member_t* mem, string value) {
+    if (mem->type == typeid(object))
+        return hold(copy(value));
+    return hold(intern_value(A_formatter(
+        mem->type, null, (object)false, (symbol)"%s", value->chars)));
+}
+
+static type_member_t* style_member(AType type, string name) {
+    for (; type && type != typeid(A); type = type->parent_type)
+        for (int m = 0; m < type->member_count; m++) {
+            type_member_t* mem = &type->members[m];
+            if ((mem->member_type & A_MEMBER_PROP) && strcmp(mem->name, name->chars) == 0)
+                return mem;
+        }
+    return null;
+}
+
+/// decodes entries of typed blocks ahead of time; untyped ones decode on first match
+static none style_decode_block(style_block bl) {
+    pairs (bl->entries, i) {
+        style_entry e = i->value;
+        if (e->instance)
+            continue;
+        each (bl->types, AType, t) {
+            type_member_t* mem = style_member(t, e->member);
+            if (mem) {
+                e->instance = style_decode(mem, e->value);
+                break;
+            }
+        }
+    }
+    each (bl->blocks, style_block, s)
+        style_decode_block(s);
+}
+
+/// parses and indexes code into an unpublished state; null with *error on a syntax error.
+/// allocates A objects and resolves shared symbols, so it runs on the style's owner thread
+static style_state* style_compile(string code, string* error) {
+    style_parse ps   = { .code = cstring(code) };
+    array       base = array(alloc, 32);
+    for (cstr sc = ps.code; sc && *sc; ws(&sc)) {
         style_block n_block = style_block(types, array(unmanaged, true));
-        push(a->base, n_block);
-        parse_block(n_block, &sc);
+        push(base, n_block);
+        if (!parse_block(&ps, n_block, &sc)) {
+            *error = hold(ps.error);
+            return null;
+        }
     }
+    mem_object(mem_style_parse, typeid(style_block), style_blocks(base));
+    return style_state_new(base);
+}
+
+/// the last compile error is kept in a->error, and printed once
+static none style_report(style a, string error) {
+    if (a->error) drop(a->error);
+    a->error = error;
+    if (error)
+        print("style: %o: %o", a->css_path, error);
+}
+
+/// parses and indexes code into a new state, then publishes it; on a syntax error the current state stays
+void style_process(style a, string code) {
+    string       error = null;
+    style_state* st    = style_compile(code, &error);
+    style_report(a, error);
+    if (st)
+        style_publish(a, st);
 }
 
 list composer_apply_args(composer ux, ion i, ion e) {
@@ -990,11 +3187,20 @@ list composer_apply_args(composer ux, ion i, ion e) {
             } else {
                 object* cur = (object*)((cstr)i + mem->offset);
                 object* nxt = (object*)((cstr)e + mem->offset);
+                bool    canonical = interned_type(mem->type);
+                if (canonical && *nxt) {
+                    object c = intern_value(*nxt);
+                    if (c != *nxt) {
+                        drop(*nxt);
+                        *nxt = hold(c);
+                    }
+                }
                 if (*nxt && *cur != *nxt) {
-                    bool is_same = (*cur && *nxt) ? compare(*cur, *nxt) == 0 : false;
+                    /// canonical values compare by pointer
+                    bool is_same = (*cur && *nxt) && !(canonical && interned(*cur) && interned(*nxt)) ?
+                        compare(*cur, *nxt) == 0 : false;
                     if (!is_same && is_set) {
                         if (*cur != *nxt) {
-                            print("prop different: %s, prev value: %o", mem->name, *cur);
                             drop(*cur);
                             *cur = hold(*nxt); // hold required here, because member dealloc happens on the other object
                             push(changed, mem->sname);
@@ -1008,9 +3214,227 @@ list composer_apply_args(composer ux, ion i, ion e) {
     return changed;
 }
 
-list composer_apply_style(composer ux, ion i, map style_avail, list exceptions) {
+/// generational references: slot + 1 in the high half, generation in the low (0 is no reference)
+/// retiring a slot bumps its generation, so references held past unmount resolve to null
+typedef struct ref_slot {
+    ion target;
+    u32 gen;
+} ref_slot;
+
+static ref_slot* refs;
+static u32       ref_count;
+static u32       ref_alloc;
+static u32*      ref_free;
+static u32       ref_free_count;
+static pthread_mutex_t ref_lock = PTHREAD_MUTEX_INITIALIZER; /// composers on several threads, and renderers resolving frame refs
+
+u64 ion_ref(ion a) {
+    if (a->ref_id)
+        return a->ref_id;
+    pthread_mutex_lock(&ref_lock);
+    u32 i;
+    if (ref_free_count)
+        i = ref_free[--ref_free_count];
+    else {
+        if (ref_count == ref_alloc) {
+            ref_alloc = ref_alloc ? ref_alloc << 1 : 1024;
+            refs      = realloc(refs,     sizeof(ref_slot) * ref_alloc); /// process lifetime
+            ref_free  = realloc(ref_free, sizeof(u32)      * ref_alloc);
+        }
+        i = ref_count++;
+        refs[i].gen = 1;
+    }
+    refs[i].target = a;
+    a->ref_id = ((u64)(i + 1) << 32) | refs[i].gen;
+    pthread_mutex_unlock(&ref_lock);
+    return a->ref_id;
+}
+
+ion ion_deref(u64 r) {
+    u32 i = (u32)(r >> 32);
+    pthread_mutex_lock(&ref_lock);
+    ion target = (i && i <= ref_count && refs[i - 1].gen == (u32)r) ? refs[i - 1].target : null;
+    pthread_mutex_unlock(&ref_lock);
+    return target;
+}
+
+static none ref_retire(ion a) {
+    if (!a->ref_id) return;
+    pthread_mutex_lock(&ref_lock);
+    u32 i = (u32)(a->ref_id >> 32) - 1;
+    refs[i].target = null;
+    refs[i].gen++;
+    ref_free[ref_free_count++] = i;
+    a->ref_id = 0;
+    pthread_mutex_unlock(&ref_lock);
+}
+
+/// parent is a weak pointer; this one is checked against the parent's reference
+ion ion_live_parent(ion a) {
+    return a->parent_ref ? ion_deref(a->parent_ref) : a->parent;
+}
+
+/// focus and capture point across the tree, so they are kept as references (ref(e)) rather than
+/// held: null once that element unmounts, and they never keep an unmounted subtree alive
+element element_focused(element a) {
+    return a->focused_ref ? (element)ion_deref(a->focused_ref) : null;
+}
+
+element element_captured(element a) {
+    return a->captured_ref ? (element)ion_deref(a->captured_ref) : null;
+}
+
+/// unmounted subtrees give their transition state back for reuse by the next mounts
+/// (scrolling lists mount and unmount the same kinds of element every frame)
+#define POOL_LIMIT 4096
+
+static style_transition* transition_pool;
+static i32               transition_pool_count;
+static pthread_mutex_t   transition_lock = PTHREAD_MUTEX_INITIALIZER; /// composers mount on their own threads
+
+/// the returned reference belongs to the caller's transitions map; the pool hands its own over
+static style_transition transition_acquire() {
+    mem_object(mem_transitions, typeid(style_transition), 1);
+    style_transition ct = null;
+    pthread_mutex_lock(&transition_lock);
+    if (transition_pool_count)
+        ct = transition_pool[--transition_pool_count];
+    pthread_mutex_unlock(&transition_lock);
+    return ct ? ct : hold(new(style_transition));
+}
+
+/// takes over the map's reference: kept by the pool, or released when the pool is full
+static none transition_recycle(style_transition ct) {
+    mem_object(mem_transitions, typeid(style_transition), -1);
+    drop(ct->from); /// inlay storage was A_alloc'd for the previous member's type
+    drop(ct->to);
+    ct->from      = null;
+    ct->to        = null;
+    ct->location  = null;
+    ct->reference = null;
+    ct->active    = false;
+    pthread_mutex_lock(&transition_lock);
+    bool pooled = transition_pool_count < POOL_LIMIT;
+    if (pooled) {
+        if (!transition_pool)
+            transition_pool = calloc(POOL_LIMIT, sizeof(style_transition)); /// process lifetime
+        transition_pool[transition_pool_count++] = ct;
+    }
+    pthread_mutex_unlock(&transition_lock);
+    if (!pooled)
+        drop(ct);
+}
+
+static none pool_release(ion n) {
+    if (n->ref_id)
+        mem_object(mem_elements, isa(n), -1);
+    ref_retire(n);
+    sym_map* tr = n->transitions;
+    if (tr) {
+        for (i32 i = 0; i < tr->alloc; i++)
+            if (tr->pairs[i].key)
+                transition_recycle(tr->pairs[i].value);
+        sym_map_free(tr);
+        n->transitions = null;
+    }
+    if (n->tasks) {
+        drop(n->tasks); /// running tasks finish on their own; their owner ref no longer resolves
+        n->tasks = null;
+    }
+    pairs(n->elements, i)
+        pool_release(i->value);
+}
+
+/// retarget a transition slot from wherever the prop is now (possibly mid-animation)
+/// the state object and its inlay 'from' storage are reused, so hover flips do not allocate
+/// values from the snapshot are shared by every composer and counted only by the publishing thread,
+/// so what an element or transition keeps is its own copy; equal values are not copied again
+static bool style_same(object cur, object v) {
+    return cur == v || (cur && v && isa(cur) == isa(v) && compare(cur, v) == 0);
+}
+
+static none style_keep(object* dst, object v) {
+    if (style_same(*dst, v))
+        return;
+    object prev = *dst;
+    *dst = v ? hold(copy(v)) : null;
+    if (prev) drop(prev);
+}
+
+static none transition_retarget(
+        style_transition ct, style_transition t, type_member_t* mem,
+        object* cur, object to, i64 frame_time) {
+    ct->easing    = t->easing;
+    ct->dir       = t->dir;
+    style_keep((object*)&ct->duration, t->duration);
+    ct->reference = t; // weak; owned by its style_entry
+    ct->is_inlay  = A_is_inlay(mem);
+    ct->type      = isa(to);
+    ct->location  = cur; /// hold onto pointer location
+    if (ct->is_inlay) {
+        if (!ct->from)
+            ct->from = A_alloc(mem->type, 1);
+        memcpy(ct->from, cur, mem->type->size);
+    } else {
+        /// the current value is whatever animate last mixed (the element's own); hold it,
+        /// since animate drops *location
+        object prev = ct->from;
+        if (*cur)
+            ct->from = hold(*cur);
+        else {
+            ct->from = null;
+            style_keep(&ct->from, to);
+        }
+        if (prev) drop(prev);
+    }
+    style_keep(&ct->to, to); /// outlives the entry when a reload retires it mid-animation
+    ct->start  = frame_time;
+    ct->active = true;
+}
+
+#ifdef ION_STYLE_TRACE
+static bool style_traced(composer ux, ion i, string prop) {
+    return ux->trace_style &&
+        (!ux->trace_id   || (i->id && eq(i->id, ux->trace_id->chars))) &&
+        (!ux->trace_prop || eq(prop, ux->trace_prop->chars));
+}
+
+/// scores every candidate again (only when traced), then records what best_match chose
+/// traced builds hold the entries they record, so trace one composer at a time
+static style_trace style_trace_begin(composer ux, ion i, string prop, array entries) {
+    if (!style_traced(ux, i, prop))
+        return null;
+    style_trace tr = style_trace(
+        id, i->id, prop, prop, candidates, array(alloc, 8));
+    each(entries, style_entry, e)
+        push(tr->candidates, style_candidate(entry, e, score, (f64)score(e->bl, i, true)));
+    if (!ux->traces)
+        ux->traces = hold(array(alloc, 64));
+    push(ux->traces, tr);
+    tr->nanos = monotonic_nanos(); /// times the selection, not the tracing itself
+    return tr;
+}
+
+static none style_trace_end(style_trace tr, style_entry best, cstr transition) {
+    if (!tr) return;
+    tr->winner     = best;
+    tr->transition = string(transition);
+    tr->nanos      = monotonic_nanos() - tr->nanos;
+}
+
+#define trace_begin(ux, i, prop, entries) style_trace tr = style_trace_begin(ux, i, prop, entries)
+#define trace_end(best, transition)       style_trace_end(tr, best, transition)
+#else
+#define trace_begin(ux, i, prop, entries)
+#define trace_end(best, transition)
+#endif
+
+/// style_avail is a style_avail from compute, entered in the same epoch (or generation)
+list composer_apply_style(composer ux, ion i, handle style_avail, list exceptions) {
     AType type = isa(i);
     list changed = list();
+    epoch_enter();
+    style_state* st = style_snapshot(ux->style);
 
     while (type != typeid(A)) {
         for (int m = 0; m < type->member_count; m++) {
@@ -1019,13 +3443,10 @@ list composer_apply_style(composer ux, ion i, map style_avail, list exceptions)
             if (!is_prop || strcmp(mem->name, "elements") == 0)
                 continue;
             
-            A info = head(mem->sname);
-            string prop    = mem->sname;
-            if (eq(prop, "area")) {
-                int test2 = 2;
-                test2 += 2;
-            }
-            list   entries = get(style_avail, prop);
+            string prop    = sym_of(mem->sname);
+            if (!st || !sym_get(st->member_index, prop))
+                continue; /// no block styles this prop; skips the map lookup
+            array  entries = style_avail_get(style_avail, prop);
             if (!entries)
                 continue;
             // dont apply over these exceptional args
@@ -1033,19 +3454,20 @@ list composer_apply_style(composer ux, ion i, map style_avail, list exceptions)
                 continue;
             
             /// compute best match for this prop against style_entries
+            trace_begin(ux, i, prop, entries);
             style_entry best = best_match(ux->style, i, prop, entries);
-            if (!best)
+            if (!best) {
+                trace_end(null, "unmatched");
                 continue;
+            }
 
             // lazily create instance value from string on style entry
-            if (!best->instance) {
-                if (mem->type == typeid(object))
-                    best->instance = hold(copy(best->value));
-                else {
-                    best->instance = hold(A_formatter(
-                        mem->type, null, (object)false,
-                        (symbol)"%s", best->value->chars));
-                }
+            // entries are shared by every composer on this style; the first decode to land is kept
+            if (!__atomic_load_n(&best->instance, __ATOMIC_ACQUIRE)) {
+                object inst = style_decode(mem, best->value), none_set = null;
+                if (!__atomic_compare_exchange_n(&best->instance, &none_set, inst,
+                        false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                    drop(inst);
             }
             verify(best->instance, "instance must be initialized");
 
@@ -1053,49 +3475,39 @@ list composer_apply_style(composer ux, ion i, map style_avail, list exceptions)
             object* cur = (object*)((cstr)i + mem->offset);
 
             style_transition t  = best->trans;
-            style_transition ct = null;
+            style_transition ct = sym_get(i->transitions, prop);
             bool should_trans = false;
             if (t) {
-                if (t && !i->transitions)
-                    i->transitions = hold(map(hsize, 16));
-                ct = i->transitions ? get(i->transitions, prop) : null;
+                if (!i->transitions)
+                    i->transitions = sym_map_new(mem_transitions);
                 if (!ct) {
-                    ct = copy(t);
-                    ct->reference = t; // mark as weak, or intern
-                    should_trans = true;
-                    set(i->transitions, prop, ct);
-                } else {
-                    should_trans = ct->reference != t;
+                    ct = transition_acquire(); /// one state object per prop, reused on every retarget
+                    sym_set(i->transitions, prop, ct);
                 }
+                should_trans = ct->reference != t;
             }
             
             // we know this is a different transition assigned
             if (ct && should_trans) {
-                // save the value where it is now
-                if (A_is_inlay(mem)) {
-                    ct->from = A_alloc(mem->type, 1);
-                    memcpy(ct->from, cur, mem->type->size);
-                } else {
-                    ct->from = *cur ? *cur : best->instance;
+                transition_retarget(ct, t, mem, cur, best->instance, ux->frame_time);
+                trace_end(best, "retarget");
+            } else if (t) {
+                trace_end(best, ct->active ? "running" : "settled");
+            } else {
+                trace_end(best, ct && ct->active ? "stopped" : "none");
+                if (ct) {
+                    ct->active    = false; /// a style without transition wins; stop the one in flight
+                    ct->reference = null;  /// so the same transition winning again retargets
                 }
-                ct->type     = isa(best->instance);
-                ct->location = cur; /// hold onto pointer location
-                if (ct->to != best->instance)
-                    ct->to  = best->instance;
-                ct->start    = epoch_millis();
-                ct->is_inlay = A_is_inlay(mem);
-            } else if (!ct) {
                 if (A_is_inlay(mem)) {
-                    print("%s cur = %p", mem->name, cur);
                     memcpy(cur, best->instance, mem->type->size);
-                } else if (*cur != best->instance) {
-                    drop(*cur);
-                    *cur = best->instance;
-                }
+                } else
+                    style_keep(cur, best->instance); /// a reload frees the entries it copies from
             }
         }
         type = type->parent_type;
     }
+    epoch_exit();
     return changed;
 }
 
@@ -1183,15 +3595,728 @@ none composer_bind_subs(composer ux, ion instance, ion parent) {
             if (selected) {
                 *field = hold(subs(entries, array(1)));
                 add(*field, selected, f);
-                button btest = instance;
-                int test2 = 2;
-                test2 += 2;
             }
         }
         type = type->parent_type;
     }
 }
 
+/// element regions resolve into one table owned by the composer, indexed by element slot
+/// columns are struct-of-arrays in a single block: x, y, w, h for each rect, then the parent rect
+enum layout_rect { layout_bounds, layout_text, layout_border, layout_clip, layout_child, layout_rects };
+
+#define layout_cols ((layout_rects + 1) * 4)
+
+typedef struct slot_table {
+    i32      count, alloc;
+    i32*     free_slots;
+    i32      free_count;
+    f32*     block;
+    f32*     col[layout_cols];
+    region*  regions;           /// regions each slot was last resolved from (layout_rects per slot), held
+    element* owner;             /// hot props, when composer->hot_props is set
+    f32*     opacity;
+    f32*     border_size;
+    object*  fill_color;
+    bool*    hover;
+    hot_table view;             /// returned by composer_hot
+    shape_cache* shapes;        /// static labels shaped for this composer
+} slot_table;
+
+static inline f32* layout_col(slot_table* t, int r, int c) {
+    return t->col[r * 4 + c];
+}
+
+static none slots_grow(slot_table* t, i32 alloc) {
+    f32* block = mem_calloc(mem_transient, (sz)alloc * layout_cols, sizeof(f32));
+    for (int c = 0; c < layout_cols; c++) {
+        f32* col = &block[(sz)c * alloc];
+        if (t->block)
+            memcpy(col, t->col[c], sizeof(f32) * t->count);
+        t->col[c] = col;
+    }
+    mem_free(t->block);
+    t->block      = block;
+    t->regions     = mem_realloc(mem_transient, t->regions,     sizeof(region)  * layout_rects * alloc);
+    t->free_slots  = mem_realloc(mem_transient, t->free_slots,  sizeof(i32)     * alloc);
+    t->owner       = mem_realloc(mem_transient, t->owner,       sizeof(element) * alloc);
+    t->opacity     = mem_realloc(mem_transient, t->opacity,     sizeof(f32)     * alloc);
+    t->border_size = mem_realloc(mem_transient, t->border_size, sizeof(f32)     * alloc);
+    t->fill_color  = mem_realloc(mem_transient, t->fill_color,  sizeof(object)  * alloc);
+    t->hover       = mem_realloc(mem_transient, t->hover,       sizeof(bool)    * alloc);
+    t->alloc       = alloc;
+}
+
+static i32 slots_acquire(slot_table* t) {
+    i32 s;
+    if (t->free_count)
+        s = t->free_slots[--t->free_count];
+    else {
+        if (t->count == t->alloc)
+            slots_grow(t, t->alloc ? t->alloc << 1 : 256);
+        s = t->count++;
+    }
+    /// NaN parent rect never compares equal, so the first layout always resolves
+    memset(&t->regions[s * layout_rects], 0, sizeof(region) * layout_rects);
+    layout_col(t, layout_rects, 0)[s] = NAN;
+    t->owner[s] = null;
+    return s;
+}
+
+/// drops the regions a slot was resolved from
+static none slots_unresolve(slot_table* t, i32 s) {
+    region* regs = &t->regions[s * layout_rects];
+    for (int r = 0; r < layout_rects; r++)
+        if (regs[r]) {
+            drop(regs[r]);
+            regs[r] = null;
+        }
+}
+
+static none slots_release(slot_table* t, ion n) {
+    element e = instanceof(n, element);
+    if (e && e->slot) {
+        slots_unresolve(t, e->slot - 1);
+        t->owner[e->slot - 1] = null;
+        t->free_slots[t->free_count++] = e->slot - 1;
+        e->slot = 0;
+    }
+    pairs(n->elements, i)
+        slots_release(t, i->value);
+}
+
+static slot_table* composer_slots(composer ux) {
+    if (!ux->slots) {
+        slot_table* t = mem_calloc(mem_transient, 1, sizeof(slot_table));
+        t->shapes = shape_cache_new();
+        ux->slots = t;
+    }
+    return ux->slots;
+}
+
+/// mirror the hot props of e into its slot; called wherever args, style or animate write them
+static none hot_sync(composer ux, ion n) {
+    element e = instanceof(n, element);
+    if (!e || !ux->hot_props)
+        return;
+    slot_table* t = composer_slots(ux);
+    if (!e->slot)
+        e->slot = slots_acquire(t) + 1;
+    i32 s = e->slot - 1;
+    t->owner      [s] = e;
+    t->opacity    [s] = e->opacity;
+    t->border_size[s] = e->border_size;
+    t->fill_color [s] = e->fill_color;
+    t->hover      [s] = e->hover;
+}
+
+/// fills the table for a whole subtree; elements only sync when something changes them,
+/// so ones mounted before hot_props was set would otherwise stay out of it
+static none hot_fill(composer ux, ion n) {
+    hot_sync(ux, n);
+    pairs(n->elements, i)
+        hot_fill(ux, i->value);
+}
+
+/// hot_table over the slot columns, for batch passes over many elements
+handle composer_hot(composer ux) {
+    slot_table* t = composer_slots(ux);
+    hot_table*  h = &t->view;
+    h->count       = t->count;
+    h->owner       = t->owner;
+    h->x           = t->count ? layout_col(t, layout_bounds, 0) : null;
+    h->y           = t->count ? layout_col(t, layout_bounds, 1) : null;
+    h->w           = t->count ? layout_col(t, layout_bounds, 2) : null;
+    h->h           = t->count ? layout_col(t, layout_bounds, 3) : null;
+    h->opacity     = t->opacity;
+    h->border_size = t->border_size;
+    h->fill_color  = t->fill_color;
+    h->hover       = t->hover;
+    return h;
+}
+
+/// the shape cache this composer lays static labels out with; only its composing thread may use it
+handle composer_shapes(composer ux) {
+    return composer_slots(ux)->shapes;
+}
+
+/// display list: each element caches the ops of its subtree in its own coordinates
+/// only elements marked by draw_invalidate (and their ancestors) rebuild; clean subtrees are copied
+typedef struct draw_run {
+    draw_op* ops;
+    i64      count, alloc;
+    bool     valid;
+    bool     painted;
+    f32      extent[4];         /// x0, y0, x1, y1 of the ops, local
+    f32      origin[2];         /// window position it was last painted at
+} draw_run;
+
+/// damage: window areas that changed since the last frame, merged down to at most DAMAGE_MAX rects
+#define DAMAGE_MAX 8
+
+typedef struct damage_set {
+    f32 rects[DAMAGE_MAX][4];   /// x0, y0, x1, y1
+    i32 count;
+} damage_set;
+
+static f32 damage_area(f32* r) {
+    return (r[2] - r[0]) * (r[3] - r[1]);
+}
+
+static none damage_union(f32* dst, f32* r) {
+    dst[0] = min(dst[0], r[0]);
+    dst[1] = min(dst[1], r[1]);
+    dst[2] = max(dst[2], r[2]);
+    dst[3] = max(dst[3], r[3]);
+}
+
+static none damage_remove(damage_set* d, i32 i) {
+    memcpy(d->rects[i], d->rects[--d->count], sizeof(d->rects[i]));
+}
+
+/// overlapping rects merge; past DAMAGE_MAX, the pair that grows least merges
+static none damage_add(damage_set* d, f32 x0, f32 y0, f32 x1, f32 y1) {
+    if (x1 <= x0 || y1 <= y0)
+        return;
+    f32 r[4] = { x0, y0, x1, y1 };
+    for (i32 i = 0; i < d->count; ) {
+        f32* o = d->rects[i];
+        if (o[0] < r[2] && r[0] < o[2] && o[1] < r[3] && r[1] < o[3]) {
+            damage_union(r, o);
+            damage_remove(d, i);
+            i = 0;
+        } else
+            i++;
+    }
+    if (d->count == DAMAGE_MAX) {
+        i32 best      = 0;
+        f32 best_cost = INFINITY;
+        for (i32 i = 0; i < d->count; i++) {
+            f32 u[4] = { r[0], r[1], r[2], r[3] };
+            damage_union(u, d->rects[i]);
+            f32 cost = damage_area(u) - damage_area(d->rects[i]) - damage_area(r);
+            if (cost < best_cost) {
+                best_cost = cost;
+                best      = i;
+            }
+        }
+        damage_union(r, d->rects[best]);
+        damage_remove(d, best);
+        damage_add(d, r[0], r[1], r[2], r[3]);
+        return;
+    }
+    memcpy(d->rects[d->count++], r, sizeof(r));
+}
+
+static none damage_run(damage_set* d, draw_run* run, f32 ox, f32 oy) {
+    if (d && run->count)
+        damage_add(d, ox + run->extent[0], oy + run->extent[1],
+                      ox + run->extent[2], oy + run->extent[3]);
+}
+
+static draw_op* draw_push(draw_run* r) {
+    if (r->count == r->alloc) {
+        r->alloc = r->alloc ? r->alloc << 1 : 16;
+        r->ops   = mem_realloc(mem_transient, r->ops, sizeof(draw_op) * r->alloc);
+    }
+    draw_op* op = &r->ops[r->count++];
+    memset(op, 0, sizeof(draw_op));
+    return op;
+}
+
+static none draw_append(draw_run* dst, draw_run* src, f32 dx, f32 dy) {
+    if (dst->count + src->count > dst->alloc) {
+        dst->alloc = (dst->count + src->count) << 1;
+        dst->ops   = mem_realloc(mem_transient, dst->ops, sizeof(draw_op) * dst->alloc);
+    }
+    draw_op* ops = &dst->ops[dst->count];
+    memcpy(ops, src->ops, sizeof(draw_op) * src->count);
+    for (i64 i = 0; i < src->count; i++) {
+        ops[i].x += dx;
+        ops[i].y += dy;
+    }
+    dst->count += src->count;
+}
+
+/// each composer pools its own runs, so composers painting on their own threads never share one
+typedef struct run_pool {
+    draw_run** runs;
+    i32        count;
+} run_pool;
+
+static run_pool* composer_runs(composer ux) {
+    if (!ux->run_pool)
+        ux->run_pool = mem_calloc(mem_transient, 1, sizeof(run_pool));
+    return ux->run_pool;
+}
+
+/// runs keep their op buffers in the pool
+static draw_run* draw_alloc(run_pool* p) {
+    if (p->count) {
+        draw_run* r = p->runs[--p->count];
+        r->count   = 0;
+        r->valid   = false;
+        r->painted = false;
+        return r;
+    }
+    return mem_calloc(mem_transient, 1, sizeof(draw_run));
+}
+
+static none draw_destroy(draw_run* r) {
+    mem_free(r->ops);
+    mem_free(r);
+}
+
+static none draw_free(run_pool* p, draw_run* r) {
+    if (!r) return;
+    if (p->count < POOL_LIMIT) {
+        if (!p->runs)
+            p->runs = mem_calloc(mem_transient, POOL_LIMIT, sizeof(draw_run*));
+        p->runs[p->count++] = r;
+        return;
+    }
+    draw_destroy(r);
+}
+
+/// destroys the pooled runs and the pool
+static none draw_drain(run_pool* p) {
+    if (!p) return;
+    while (p->count)
+        draw_destroy(p->runs[--p->count]);
+    mem_free(p->runs);
+    mem_free(p);
+}
+
+/// the element repaints; ancestors rebuild their runs around it
+static none draw_invalidate(ion n) {
+    element e = instanceof(n, element);
+    if (e) e->draw_dirty = true;
+    for (ion p = live_parent(n); p; p = live_parent(p)) {
+        element pe = instanceof(p, element);
+        if (!pe || pe->draw_tree) break;
+        pe->draw_tree = true;
+    }
+}
+
+/// the removed subtree's last painted area is damaged (its extent covers the descendants)
+static none draw_release(run_pool* p, damage_set* d, ion n) {
+    element   e   = instanceof(n, element);
+    draw_run* run = e ? e->draw : null;
+    if (run) {
+        if (run->painted)
+            damage_run(d, run, run->origin[0], run->origin[1]);
+        draw_free(p, run);
+        e->draw = null;
+    }
+    pairs(n->elements, i)
+        draw_release(p, null, i->value);
+}
+
+static none draw_rect(draw_op* op, draw_kind kind, element e, rect r) {
+    op->kind    = kind;
+    op->source  = e;
+    op->x       = r->x;
+    op->y       = r->y;
+    op->w       = r->w;
+    op->h       = r->h;
+    op->opacity = e->opacity;
+}
+
+/// ox, oy is the element's window position; repainted or moved subtrees damage where they were and are
+static draw_run* draw_subtree(run_pool* p, element e, damage_set* d, f32 ox, f32 oy) {
+    draw_run* run = e->draw;
+    if (!run)
+        e->draw = run = draw_alloc(p);
+    bool moved = run->painted && (run->origin[0] != ox || run->origin[1] != oy);
+    bool self  = !run->valid || e->draw_dirty || moved;
+    if (self && run->painted)
+        damage_run(d, run, run->origin[0], run->origin[1]);
+    run->origin[0] = ox;
+    run->origin[1] = oy;
+    run->painted   = true;
+    if (run->valid && !e->draw_dirty && !e->draw_tree) {
+        if (moved)
+            damage_run(d, run, ox, oy);
+        return run;
+    }
+    run->count = 0;
+
+    if (e->fill_color && e->fill_bounds) {
+        draw_op* op = draw_push(run);
+        draw_rect(op, draw_kind_fill, e, e->fill_bounds);
+        op->radius_x = e->fill_radius_x;
+        op->radius_y = e->fill_radius_y;
+        op->blur     = e->fill_blur;
+        op->color    = e->fill_color;
+        op->canvas   = e->fill_canvas;
+    }
+    if (e->border_color && e->border_size > 0 && e->border_bounds) {
+        draw_op* op = draw_push(run);
+        draw_rect(op, draw_kind_border, e, e->border_bounds);
+        op->radius_x = e->border_radius_x;
+        op->radius_y = e->border_radius_y;
+        op->size     = e->border_size;
+        op->blur     = e->border_blur;
+        op->color    = e->border_color;
+        op->canvas   = e->border_canvas;
+    }
+    object content = e->shape ? (object)e->shape : e->lines ? (object)e->lines : e->content;
+    if (content && e->text_bounds) {
+        draw_op* op = draw_push(run);
+        draw_rect(op, draw_kind_text, e, e->text_bounds);
+        op->size    = e->text_scale;
+        op->color   = e->text_color;
+        op->content = content;
+    }
+    if (e->elements && e->child_bounds) {
+        draw_op* push = draw_push(run);
+        draw_rect(push, draw_kind_clip_push, e, e->clip_bounds ? e->clip_bounds : e->bounds);
+        if (!e->clip_bounds) {
+            push->x = 0;
+            push->y = 0;
+        }
+        pairs(e->elements, i) {
+            element c = instanceof(i->value, element);
+            if (!c || !c->bounds) continue;
+            f32 cx = e->child_bounds->x + c->bounds->x;
+            f32 cy = e->child_bounds->y + c->bounds->y;
+            /// a repainted element damages its whole extent already
+            draw_append(run, draw_subtree(p, c, self ? null : d, ox + cx, oy + cy), cx, cy);
+        }
+        draw_op* pop = draw_push(run);
+        pop->kind   = draw_kind_clip_pop;
+        pop->source = e;
+    }
+
+    f32* x = run->extent;
+    x[0] = x[1] =  INFINITY;
+    x[2] = x[3] = -INFINITY;
+    for (i64 i = 0; i < run->count; i++) {
+        draw_op* op = &run->ops[i];
+        if (op->kind == draw_kind_clip_pop) continue;
+        f32 r[4] = { op->x, op->y, op->x + op->w, op->y + op->h };
+        damage_union(x, r);
+    }
+    if (self)
+        damage_run(d, run, ox, oy);
+    run->valid    = true;
+    e->draw_dirty = false;
+    e->draw_tree  = false;
+    return run;
+}
+
+/// rebuild the display list from laid-out bounds; the previous frame's buffer is kept to diff against
+/// draw_changed is the first op that differs from the previous frame (-1 when the frame is identical)
+none composer_paint(composer ux) {
+    draw_run* last = ux->draw_ops;
+    draw_run* next = ux->draw_prev;
+    if (!last) last = mem_calloc(mem_transient, 1, sizeof(draw_run));
+    if (!next) next = mem_calloc(mem_transient, 1, sizeof(draw_run));
+    next->count   = 0;
+    ux->draw_ops  = next;
+    ux->draw_prev = last;
+
+    damage_set* d = ux->damage_set;
+    if (!d) ux->damage_set = d = mem_calloc(mem_transient, 1, sizeof(damage_set));
+
+    element root = instanceof(ux->root, element);
+    if (root && root->bounds)
+        draw_append(next, draw_subtree(composer_runs(ux), root, d, root->bounds->x, root->bounds->y),
+            root->bounds->x, root->bounds->y);
+
+    i64 n = min(next->count, last->count);
+    i64 i = 0;
+    while (i < n && memcmp(&next->ops[i], &last->ops[i], sizeof(draw_op)) == 0) i++;
+    ux->draw_changed = (i == n && next->count == last->count) ? -1 : i;
+    ux->draw_count   = next->count;
+}
+
+/// draw_op[draw_count], valid until the next paint
+handle composer_display(composer ux) {
+    draw_run* r = ux->draw_ops;
+    return r ? r->ops : null;
+}
+
+/// frame profile: PROF_FRAMES most recent frames, oldest overwritten
+#define PROF_FRAMES 256
+
+typedef struct prof_ring {
+    frame_stats frames[PROF_FRAMES];
+    i64         count;          /// frames recorded; the current one is (count - 1) % PROF_FRAMES
+} prof_ring;
+
+static cstr prof_names[prof_phases] = {
+    "check_reload", "compute", "apply_args", "apply_style", "render", "bind_subs",
+    "umount", "animate", "layout", "paint" };
+
+#ifdef ION_PROFILE
+#define prof_frame(ux)                  prof_frame_begin(ux)
+#define prof_frame_end(ux)              prof_frame_done(ux)
+#define prof_begin(phase)               i64 prof_t_##phase = monotonic_nanos()
+#define prof_end(ux, phase)             prof_add(ux, prof_##phase, monotonic_nanos() - prof_t_##phase)
+#define prof_count(ux, counter, n)      prof_counter(ux)->counter += (n)
+
+static frame_stats* prof_counter(composer ux) {
+    prof_ring* r = ux->prof;
+    if (!r) {
+        ux->prof = r = mem_calloc(mem_transient, 1, sizeof(prof_ring));
+        r->count = 1;
+    }
+    return &r->frames[(r->count - 1) % PROF_FRAMES];
+}
+
+static none prof_add(composer ux, prof_phase phase, i64 nanos) {
+    prof_counter(ux)->nanos[phase] += nanos;
+}
+
+static none prof_frame_begin(composer ux) {
+    prof_ring* r = ux->prof;
+    if (!r)
+        ux->prof = r = mem_calloc(mem_transient, 1, sizeof(prof_ring));
+    frame_stats* f = &r->frames[r->count % PROF_FRAMES];
+    memset(f, 0, sizeof(frame_stats));
+    f->frame = r->count++;
+    f->start = monotonic_nanos();
+}
+
+static none prof_frame_done(composer ux) {
+    frame_stats* f = prof_counter(ux);
+    f->total = monotonic_nanos() - f->start;
+}
+#else
+#define prof_frame(ux)
+#define prof_frame_end(ux)
+#define prof_begin(phase)
+#define prof_end(ux, phase)
+#define prof_count(ux, counter, n)
+#endif
+
+/// frame_stats for the frame 'back' frames ago (0 is the latest), or null; always null without ION_PROFILE
+handle composer_profile(composer ux, num back) {
+    prof_ring* r = ux->prof;
+    if (!r || back < 0 || back >= r->count || back >= PROF_FRAMES)
+        return null;
+    return &r->frames[(r->count - 1 - back) % PROF_FRAMES];
+}
+
+typedef struct trace_buf {
+    char* chars;
+    i64   len, alloc;
+} trace_buf;
+
+static none trace_emit(trace_buf* b, cstr fmt, ...) {
+    va_list args;
+    for (;;) {
+        va_start(args, fmt);
+        i64 room = b->alloc - b->len;
+        i64 n    = vsnprintf(&b->chars[b->len], room, fmt, args);
+        va_end(args);
+        if (n < room) {
+            b->len += n;
+            return;
+        }
+        b->alloc = (b->alloc + n) << 1;
+        b->chars = mem_realloc(mem_transient, b->chars, b->alloc);
+    }
+}
+
+/// the ring as Chrome trace JSON (chrome://tracing, Perfetto); each frame is a span with its
+/// phases laid end to end inside it (phase totals, not their interleaving), and counters alongside
+string composer_profile_trace(composer ux) {
+    prof_ring* r = ux->prof;
+    trace_buf  b = { .chars = mem_malloc(mem_transient, 4096), .alloc = 4096 };
+    i64        n     = r ? min(r->count, PROF_FRAMES) : 0;
+    i64        first = r ? r->count - n : 0;
+    trace_emit(&b, "{\"traceEvents\":[");
+    for (i64 i = first; i < first + n; i++) {
+        frame_stats* f  = &r->frames[i % PROF_FRAMES];
+        f64          ts = f->start / 1000.0;
+        trace_emit(&b, "%s{\"name\":\"frame %lld\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+            i > first ? "," : "", (long long)f->frame, ts, f->total / 1000.0);
+        for (int p = 0; p < prof_phases; p++) {
+            if (!f->nanos[p]) continue;
+            trace_emit(&b, ",{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                prof_names[p], ts, f->nanos[p] / 1000.0);
+            ts += f->nanos[p] / 1000.0;
+        }
+        trace_emit(&b, ",{\"name\":\"elements\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{"
+            "\"visited\":%i,\"restyled\":%i,\"mounted\":%i,\"unmounted\":%i,\"transitions\":%i}}",
+            f->start / 1000.0, f->visited, f->restyled, f->mounted, f->unmounted, f->transitions);
+    }
+    trace_emit(&b, "]}");
+    string res = string(chars, b.chars, ref_length, b.len);
+    mem_free(b.chars);
+    return res;
+}
+
+/// render tasks
+/// a component whose render needs slow data calls await(self, key, fn, arg) and returns null until it
+/// has a result; null keeps its previous children, and the composer carries on with the rest of the
+/// tree.  fn runs on the composer's workers (task_workers, 2 by default); each finished task calls
+/// composer->on_wake (a composer_wake, from the worker thread) so an idle app schedules a frame, and
+/// is collected at the next frame start, which sets composer->woke
+#define TASK_WORKERS_MAX 16
+
+typedef struct task_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;
+    ion_task*       queued;     /// ring
+    i32             head, count, alloc;
+    ion_task*       finished;
+    i32             finished_count, finished_alloc;
+    i32             outstanding; /// submitted and not yet collected
+    pthread_t       workers[TASK_WORKERS_MAX];
+    i32             worker_count;
+    bool            stop;
+    composer_wake   on_wake;    /// copied from the composer on submit; read under lock
+    handle          wake_arg;
+} task_queue;
+
+static void* task_worker(void* arg) {
+    task_queue* q = arg;
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        while (!q->count && !q->stop)
+            pthread_cond_wait(&q->wake, &q->lock);
+        if (!q->count) {
+            pthread_mutex_unlock(&q->lock);
+            return null;
+        }
+        ion_task t = q->queued[q->head];
+        q->head    = (q->head + 1) % q->alloc;
+        q->count--;
+        pthread_mutex_unlock(&q->lock);
+
+        object r = ((task_fn)t->fn)(t->arg);
+        t->result = r ? hold(r) : null;
+        __atomic_store_n(&t->done, true, __ATOMIC_RELEASE);
+
+        pthread_mutex_lock(&q->lock);
+        if (q->finished_count == q->finished_alloc) {
+            q->finished_alloc = q->finished_alloc ? q->finished_alloc << 1 : 32;
+            q->finished = mem_realloc(mem_transient, q->finished, sizeof(ion_task) * q->finished_alloc);
+        }
+        q->finished[q->finished_count++] = t;
+        composer_wake on_wake  = q->on_wake;
+        handle        wake_arg = q->wake_arg;
+        pthread_mutex_unlock(&q->lock);
+        if (on_wake)
+            on_wake(wake_arg);
+    }
+}
+
+static task_queue* task_queue_new(i32 workers) {
+    task_queue* q = mem_calloc(mem_transient, 1, sizeof(task_queue));
+    pthread_mutex_init(&q->lock, null);
+    pthread_cond_init(&q->wake, null);
+    workers = workers < 1 ? 1 : workers > TASK_WORKERS_MAX ? TASK_WORKERS_MAX : workers;
+    for (i32 i = 0; i < workers; i++)
+        if (pthread_create(&q->workers[q->worker_count], null, task_worker, q) == 0)
+            q->worker_count++;
+    return q;
+}
+
+static none task_submit(composer ux, ion_task t) {
+    task_queue* q = ux->executor;
+    if (!q)
+        q = ux->executor = task_queue_new(ux->task_workers ? ux->task_workers : 2);
+    hold(t); /// the queue's reference, released when collected
+    q->outstanding++;
+    if (!q->worker_count) {
+        /// no threads could be started; run inline rather than never finishing
+        object r = ((task_fn)t->fn)(t->arg);
+        t->result = r ? hold(r) : null;
+        t->done   = true;
+        drop(t);
+        q->outstanding--;
+        return;
+    }
+    pthread_mutex_lock(&q->lock);
+    if (q->count == q->alloc) {
+        i32       alloc = q->alloc ? q->alloc << 1 : 32;
+        ion_task* ring  = mem_calloc(mem_transient, alloc, sizeof(ion_task));
+        for (i32 i = 0; i < q->count; i++)
+            ring[i] = q->queued[(q->head + i) % q->alloc];
+        mem_free(q->queued);
+        q->queued = ring;
+        q->head   = 0;
+        q->alloc  = alloc;
+    }
+    q->queued[(q->head + q->count++) % q->alloc] = t;
+    q->on_wake  = (composer_wake)ux->on_wake;
+    q->wake_arg = ux->wake_arg;
+    pthread_cond_signal(&q->wake);
+    pthread_mutex_unlock(&q->lock);
+}
+
+/// releases finished tasks; woke is set when one of them still has a mounted owner
+static none task_collect(composer ux) {
+    task_queue* q = ux->executor;
+    ux->woke = false;
+    if (!q || !q->outstanding)
+        return;
+    pthread_mutex_lock(&q->lock);
+    i32       n    = q->finished_count;
+    ion_task* done = q->finished;
+    q->finished       = null;
+    q->finished_count = 0;
+    q->finished_alloc = 0;
+    pthread_mutex_unlock(&q->lock);
+    for (i32 i = 0; i < n; i++) {
+        if (ion_deref(done[i]->owner))
+            ux->woke = true;
+        drop(done[i]);
+    }
+    q->outstanding -= n;
+    mem_free(done);
+}
+
+/// workers finish their current task; queued ones are dropped without running
+static none task_queue_free(task_queue* q) {
+    if (!q) return;
+    pthread_mutex_lock(&q->lock);
+    q->stop = true;
+    for (i32 i = 0; i < q->count; i++)
+        drop(q->queued[(q->head + i) % q->alloc]);
+    q->count = 0;
+    pthread_cond_broadcast(&q->wake);
+    pthread_mutex_unlock(&q->lock);
+    for (i32 i = 0; i < q->worker_count; i++)
+        pthread_join(q->workers[i], null);
+    for (i32 i = 0; i < q->finished_count; i++)
+        drop(q->finished[i]);
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->wake);
+    mem_free(q->queued);
+    mem_free(q->finished);
+    mem_free(q);
+}
+
+/// tasks submitted and not yet collected by a frame
+i32 composer_pending(composer ux) {
+    task_queue* q = ux->executor;
+    return q ? q->outstanding : 0;
+}
+
+/// result of fn(arg) under key, or null while it runs.  arg compares by pointer: a different object
+/// starts a new task even when equal in value, so callers pass the same instance (or an interned
+/// one) until they want new data.  the previous result is no longer returned once superseded
+object ion_await(ion a, symbol key, handle fn, object arg) {
+    verify(a->composer, "await: %s is not mounted", isa(a)->name);
+    string   k = ion_symbol(key, strlen(key));
+    ion_task t = a->tasks ? get(a->tasks, k) : null;
+    if (!t || t->arg != arg || t->fn != fn) {
+        t = ion_task(arg, arg);
+        t->fn    = fn;
+        t->owner = ref(a);
+        if (!a->tasks)
+            a->tasks = hold(map(hsize, 8));
+        set(a->tasks, k, t);
+        task_submit(a->composer, t);
+    }
+    return __atomic_load_n(&t->done, __ATOMIC_ACQUIRE) ? t->result : null;
+}
+
 none composer_update(composer ux, ion parent, map rendered_elements) {
     object target = ux->app; // app not defined in ion, but we need only care about the A-type bind api
     
@@ -1209,6 +4334,7 @@ none composer_update(composer ux, ion parent, map rendered_elements) {
         element instance = parent->elements ? get(parent->elements, id) : null; // needs hook for free on a very specific object
         AType   type     = isa(e);
         bool    restyle  = ux->restyle;
+        prof_count(ux, visited, 1);
 
         if (instance) {
             instance->mark = 0; // instance found (pandora tomorrow...)
@@ -1216,6 +4342,10 @@ none composer_update(composer ux, ion parent, map rendered_elements) {
                 array mounted_props = array();
                 instance->id = hold(id);
                 instance->parent = parent;
+                instance->parent_ref = ref(parent);
+                instance->composer   = ux;
+                ref(instance);
+                mem_object(mem_elements, isa(instance), 1);
                 //instance->elements = hold(instance->elements);
 
                 AType ty = isa(instance);
@@ -1230,7 +4360,9 @@ none composer_update(composer ux, ion parent, map rendered_elements) {
                 // this is where we bind events between
                 // these components from component, to parent, 
                 // all the way to app controller
+                prof_begin(bind);
                 bind_subs(ux, instance, parent);
+                prof_end(ux, bind);
 
                 mount(instance, mounted_props);
                 drop(mounted_props);
@@ -1239,6 +4371,7 @@ none composer_update(composer ux, ion parent, map rendered_elements) {
 
         list changed   = null;
         bool new_inst  = false;
+        bool repaint   = false;
         if (!instance) {
             new_inst   = true;
             restyle    = true;
@@ -1249,19 +4382,36 @@ none composer_update(composer ux, ion parent, map rendered_elements) {
             m_header = A_header(m);
             //A_hold_members(instance);
             AType itype = isa(instance);
+            intern_props(instance);
             instance->id     = hold(id);
             instance->parent = parent; /// weak reference
+            instance->parent_ref = ref(parent);
+            instance->composer   = ux;
+            ref(instance);
+            mem_object(mem_elements, isa(instance), 1);
             if (!parent->elements)
                  parent->elements = hold(map(hsize, 44));
             set (parent->elements, id, instance);
+            prof_count(ux, mounted, 1);
         } else if (!restyle) {
+            prof_begin(args);
             changed = apply_args(ux, instance, e);
             restyle = index_of(changed, string("tags")) >= 0; // tags effects style application
+            prof_end(ux, args);
         }
         if (restyle) {
-            map  avail  = compute(ux->style, instance);
+            epoch_enter(); /// the candidates are the snapshot's, unheld; keep it until applied
+            prof_begin(compute);
+            style_avail* avail = compute(ux->style, instance);
+            prof_end(ux, compute);
+            prof_begin(style);
             list styled = apply_style(ux, instance, avail, changed);
+            prof_end(ux, style);
+            style_avail_free(avail);
+            epoch_exit();
+            prof_count(ux, restyled, 1);
             element e_inst = instance;
+            repaint |= styled && len(styled) > 0;
             /// merge unique props changed from style
             if (styled && changed)
                 each(styled, string, prop) {
@@ -1270,7 +4420,14 @@ none composer_update(composer ux, ion parent, map rendered_elements) {
                         push(changed, prop);
                 }
         }
+        if (new_inst || repaint || (changed && len(changed) > 0)) {
+            draw_invalidate(instance);
+            hot_sync(ux, instance);
+        }
+        prof_begin(render);
         map irender = render(instance, changed);     // first render has a null changed; clear way to perform init/mount logic
+                                                     // null keeps the current children (a render awaiting a task)
+        prof_end(ux, render);
         drop(changed);
         if (irender) {
             update(ux, instance, irender);
@@ -1278,6 +4435,7 @@ none composer_update(composer ux, ion parent, map rendered_elements) {
     }
 
     /// perform umount on elements not updated in render
+    prof_begin(umount);
     bool retry = true;
     while (retry) {
         retry = false;
@@ -1288,25 +4446,52 @@ none composer_update(composer ux, ion parent, map rendered_elements) {
                 e->mark = 0;
                 retry = true;
                 umount(e);
+                if (ux->slots)
+                    slots_release(ux->slots, e);
+                if (!ux->damage_set)
+                    ux->damage_set = mem_calloc(mem_transient, 1, sizeof(damage_set));
+                draw_release(composer_runs(ux), ux->damage_set, e);
+                draw_invalidate(parent);
+                pool_release(e);
                 rm(parent->elements, (object)id);
                 e->parent = null;
+                prof_count(ux, unmounted, 1);
                 break;
             }
         }
     }
+    prof_end(ux, umount);
 }
 
 void animate_element(composer ux, element e) {
-    if (e->transitions) {
-        i64 cur_millis = epoch_millis();
-
-        pairs(e->transitions, i) {
-            string prop = i->key;
-            style_transition ct = i->value;
-            i64 dur = tcoord_get_millis(ct->duration);
-            i64 millis = cur_millis - ct->start;
-            f64 cur_pos = style_transition_pos(ct, (f64)millis / (f64)dur);
-            if (ct->type->traits & A_TRAIT_PRIMITIVE) {
+    bool animated = false;
+    sym_map* tr = e->transitions;
+    if (tr) {
+        i64 cur_nanos = ux->frame_time;
+
+        for (i32 i = 0; i < tr->alloc; i++) {
+            style_transition ct = tr->pairs[i].value;
+            if (!ct || !ct->active)
+                continue;
+            draw_invalidate(e);
+            animated = true;
+            prof_count(ux, transitions, 1);
+            i64  dur     = tcoord_get_nanos(ct->duration);
+            i64  nanos   = cur_nanos - ct->start;
+            bool done    = nanos >= dur;
+            f64  cur_pos = style_transition_pos(ct, dur > 0 ? (f64)nanos / (f64)dur : 1.0);
+            if (!done)
+                ux->animating++;
+            if (done) {
+                /// land exactly on the target and retire; the slot stays for the next retarget
+                if (ct->is_inlay)
+                    memcpy(ct->location, ct->to, ct->type->size);
+                else if (*ct->location != ct->to) {
+                    drop(*ct->location);
+                    *ct->location = hold(ct->to);
+                }
+                ct->active = false;
+            } else if (ct->type->traits & A_TRAIT_PRIMITIVE) {
                 verify(ct->is_inlay, "unsupported member type (primitive in object form)");
                 /// mix these primitives; lets support i32 / enum, i64, f32, f64
                 AType ct_type = ct->type;
@@ -1317,37 +4502,592 @@ void animate_element(composer ux, element e) {
                 typedef object(*mix_fn)(object, object, f32);
                 drop(*ct->location);
                 *ct->location = ((mix_fn)fmix->ptr)(ct->from, ct->to, cur_pos);
-                if (eq(prop, "area")) {
-                    verify(e->area == *ct->location, "strange");
-                }
                 /// call mix dynamically; A_method to look it up
             }
         }
     }
+    if (animated)
+        hot_sync(ux, e);
     pairs(e->elements, i) { // todo: do we need mounts as separate map?
         element ee = i->value;
         animate_element(ux, ee);
     }
 }
 
+/// animating counts the transitions still in flight after this step
 void composer_animate(composer ux) {
+    prof_begin(animate);
+    ux->animating = 0;
     animate_element(ux, ux->root);
+    prof_end(ux, animate);
+}
+
+/// default time source; wall-clock (epoch) time jumps when the system clock is adjusted
+static i64 monotonic_nanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (i64)ts.tv_sec * 1000000000 + (i64)ts.tv_nsec;
+}
+
+i64 composer_now(composer ux) {
+    if (ux->time_source)
+        return ((ion_clock)ux->time_source)((object)ux);
+    return monotonic_nanos();
+}
+
+/// one frame_time per frame, shared by style application and animate
+/// with frame_step set, time advances by a fixed amount per frame (headless rendering, tests)
+none composer_tick(composer ux) {
+    if (ux->frame_step > 0)
+        ux->frame_time += ux->frame_step;
+    else
+        ux->frame_time  = now(ux);
+}
+
+static none layout_sync(rect* dst, f32* v) {
+    if (!*dst) {
+        *dst = hold(rect(x, v[0], y, v[1], w, v[2], h, v[3]));
+        return;
+    }
+    (*dst)->x = v[0];
+    (*dst)->y = v[1];
+    (*dst)->w = v[2];
+    (*dst)->h = v[3];
+}
+
+/// bounds are relative to the parent's child rect, the others (and fill_bounds) relative to the element itself
+/// a slot is reused as-is when its parent rect and region objects are unchanged
+static none layout_element(slot_table* t, ion n, f32* win) {
+    element e = instanceof(n, element);
+    f32  inner[4];
+    f32* child_win = win;
+    if (e) {
+        if (!e->slot)
+            e->slot = slots_acquire(t) + 1;
+        i32     s    = e->slot - 1;
+        region* regs = &t->regions[s * layout_rects];
+        region  cur[layout_rects] = {
+            e->area, e->text_area, e->border_area, e->clip_area, e->child_area };
+        rect*   dst[layout_rects] = {
+            &e->bounds, &e->text_bounds, &e->border_bounds, &e->clip_bounds, &e->child_bounds };
+        bool same = true;
+        for (int c = 0; c < 4; c++)
+            same &= layout_col(t, layout_rects, c)[s] == win[c];
+        for (int r = 0; r < layout_rects; r++)
+            same &= regs[r] == cur[r];
+
+        if (!same) {
+            f32 out[4];
+            f32 local[4];
+            for (int r = 0; r < layout_rects; r++) {
+                region_resolve(cur[r], r == layout_bounds ? win : local, out);
+                if (r == layout_bounds) {
+                    local[0] = 0;      local[1] = 0;
+                    local[2] = out[2]; local[3] = out[3];
+                }
+                for (int c = 0; c < 4; c++)
+                    layout_col(t, r, c)[s] = out[c];
+                layout_sync(dst[r], out);
+                if (regs[r] != cur[r]) {
+                    /// held, so a freed region's address can't be reused and compare equal
+                    if (regs[r]) drop(regs[r]);
+                    regs[r] = cur[r] ? hold(cur[r]) : null;
+                }
+            }
+            layout_sync(&e->fill_bounds, local); /// fill covers the element's own extent
+            for (int c = 0; c < 4; c++)
+                layout_col(t, layout_rects, c)[s] = win[c];
+            draw_invalidate(n);
+        }
+        /// children resolve against the child rect at the origin; draw offsets them by child_bounds
+        inner[0] = 0;
+        inner[1] = 0;
+        inner[2] = layout_col(t, layout_child, 2)[s];
+        inner[3] = layout_col(t, layout_child, 3)[s];
+        child_win = inner;
+
+        /// multiline text lays out only what scroll and clip_bounds show
+        if (e->multiline && e->lines && e->font) {
+            f64 spacing = e->text_spacing.y > 0 ? e->text_spacing.y : 1.0;
+            f64 lh      = (height_fn ? height_fn(e->font) : 0.0) * spacing;
+            f64 top     = e->scroll.y;
+            layout(e->lines, e->font, lh, 0.0, top, top + layout_col(t, layout_clip, 3)[s]);
+        } else if (e->font && e->content && isa(e->content) == typeid(string)) {
+            /// static labels: a cache lookup unless content, font or the text rect changed
+            f32  scale = e->text_scale > 0 ? e->text_scale : 1.0f;
+            f64  lh    = (height_fn ? height_fn(e->font) : 0.0) * scale *
+                         (e->text_spacing.y > 0 ? e->text_spacing.y : 1.0);
+            text_shape shape = shape_text(t->shapes, e->content, e->font, scale,
+                layout_col(t, layout_text, 2)[s], layout_col(t, layout_text, 3)[s], lh,
+                e->text_align_x, e->text_align_y, e->text_ellipsis);
+            if (shape != e->shape) {
+                drop(e->shape);
+                e->shape = hold(shape);
+                draw_invalidate(n);
+            }
+        }
+    }
+    list_view lv = instanceof(n, list_view);
+    pairs(n->elements, i) {
+        if (lv) {
+            f32 row_win[4];
+            list_view_row(lv, i->value, child_win, row_win);
+            layout_element(t, i->value, row_win);
+        } else
+            layout_element(t, i->value, child_win);
+    }
+}
+
+/// resolve area, text_area, border_area, clip_area and child_area for the whole tree in one traversal
+none composer_layout(composer ux, rect win) {
+    slot_table* t = composer_slots(ux);
+    i64 start = monotonic_nanos();
+    f32 w[4]  = { win->x, win->y, win->w, win->h };
+    if (ux->root)
+        layout_element(t, ux->root, w);
+    ux->layout_nanos = monotonic_nanos() - start;
+}
+
+/// damage accumulated since the last call, clipped to the window; resets the set
+static array damage_flush(composer ux) {
+    damage_set* d = ux->damage_set;
+    if (!ux->damage)
+        ux->damage = hold(array(alloc, DAMAGE_MAX));
+    else
+        clear(ux->damage);
+    if (!d) return ux->damage;
+    rect win = ux->bounds;
+    for (i32 i = 0; i < d->count; i++) {
+        f32* r  = d->rects[i];
+        f32  x0 = max(r[0], win->x), x1 = min(r[2], win->x + win->w);
+        f32  y0 = max(r[1], win->y), y1 = min(r[3], win->y + win->h);
+        if (x1 > x0 && y1 > y0)
+            push(ux->damage, rect(x, x0, y, y0, w, x1 - x0, h, y1 - y0));
+    }
+    d->count = 0;
+    return ux->damage;
+}
+
+static none slots_free(slot_table* t) {
+    for (i32 s = 0; s < t->count; s++)
+        slots_unresolve(t, s);
+    mem_free(t->block);
+    mem_free(t->regions);
+    mem_free(t->free_slots);
+    mem_free(t->owner);
+    mem_free(t->opacity);
+    mem_free(t->border_size);
+    mem_free(t->fill_color);
+    mem_free(t->hover);
+    shape_cache_free(t->shapes);
+    mem_free(t);
+}
+
+/// published frames: triple buffered so the composing thread never waits on the renderer.
+/// the composer fills back, then swaps it into ready; the renderer swaps ready into front when fresh
+#define FRAME_FRESH 4
+
+typedef struct frame_buffers {
+    frame_snapshot slot[3];
+    u32            ready;       /// slot index, | FRAME_FRESH when not yet taken
+    u64            serial;
+    i32            back;        /// composing thread
+    i32            front;       /// rendering thread
+} frame_buffers;
+
+static none frame_release(frame_snapshot* f) {
+    for (i64 i = 0; i < f->count; i++) {
+        if (f->ops[i].color)   drop(f->ops[i].color);
+        if (f->ops[i].content) drop(f->ops[i].content);
+    }
+    f->count = 0;
+}
+
+static line_info frame_line(line_info l) {
+    line_info c = line_info(data, string(chars, l->data->chars, ref_length, l->len), len, l->len);
+    if (l->adv) {
+        c->adv      = mem_malloc(mem_text, sizeof(f64) * (l->len + 1));
+        c->adv_font = hold(l->adv_font);
+        memcpy(c->adv, l->adv, sizeof(f64) * (l->len + 1));
+    }
+    if (l->bounds)
+        c->bounds = hold(rect(x, l->bounds->x, y, l->bounds->y, w, l->bounds->w, h, l->bounds->h));
+    return c;
+}
+
+/// held copy of op content the composing thread may change in place while a renderer reads the
+/// snapshot: strings are copied, and a text becomes an array of its visible lines (line_info).
+/// shapes are never changed once built, so they are shared
+static object frame_freeze(object content) {
+    AType type = isa(content);
+    if (type == typeid(string)) {
+        string s = content;
+        return hold(string(chars, s->chars, ref_length, s->len));
+    }
+    if (type == typeid(text)) {
+        text  a     = content;
+        array lines = array(alloc, a->view_count > 0 ? a->view_count : 1);
+        for (num row = a->view_first; row < a->view_first + a->view_count; row++)
+            push(lines, frame_line(text_line(a, row)));
+        return hold(lines);
+    }
+    return hold(content);
+}
+
+/// copies this frame's display list and damage into the back buffer and publishes it
+static none frame_publish(composer ux) {
+    frame_buffers* fb = ux->frames;
+    if (!fb) return;
+    frame_snapshot* f = &fb->slot[fb->back];
+    draw_run*       r = ux->draw_ops;
+    i64             n = r ? r->count : 0;
+    frame_release(f);
+    if (n > f->alloc) {
+        f->alloc = n + (n >> 1);
+        mem_free(f->ops);
+        mem_free(f->refs);
+        f->ops  = mem_malloc(mem_transient, sizeof(draw_op) * f->alloc);
+        f->refs = mem_malloc(mem_transient, sizeof(u64)     * f->alloc);
+    }
+    if (n)
+        memcpy(f->ops, r->ops, sizeof(draw_op) * n);
+    for (i64 i = 0; i < n; i++) {
+        draw_op* op = &f->ops[i];
+        f->refs[i]  = op->source ? op->source->ref_id : 0;
+        op->source  = null; /// elements change under the composer; identity goes by ref
+        if (op->color)   hold(op->color);    /// animate replaces colors, never changes one
+        if (op->content) op->content = frame_freeze(op->content);
+    }
+    f->count = n;
+
+    i32 dn = ux->damage ? (i32)len(ux->damage) : 0;
+    if (dn > f->damage_alloc) {
+        mem_free(f->damage);
+        f->damage_alloc = DAMAGE_MAX > dn ? DAMAGE_MAX : dn;
+        f->damage = mem_malloc(mem_transient, sizeof(f32) * 4 * f->damage_alloc);
+    }
+    i32 di = 0;
+    if (dn)
+        each (ux->damage, rect, d) {
+            f->damage[di * 4 + 0] = d->x;
+            f->damage[di * 4 + 1] = d->y;
+            f->damage[di * 4 + 2] = d->w;
+            f->damage[di * 4 + 3] = d->h;
+            di++;
+        }
+    f->damage_count = di;
+    rect b = ux->bounds;
+    f->bounds[0]  = b ? b->x : 0;
+    f->bounds[1]  = b ? b->y : 0;
+    f->bounds[2]  = b ? b->w : 0;
+    f->bounds[3]  = b ? b->h : 0;
+    f->frame_time = ux->frame_time;
+    f->serial     = ++fb->serial;
+    u32 prev = __atomic_exchange_n(&fb->ready, (u32)fb->back | FRAME_FRESH, __ATOMIC_ACQ_REL);
+    fb->back = prev & 3;
+}
+
+static frame_buffers* frame_buffers_new() {
+    frame_buffers* fb = mem_calloc(mem_transient, 1, sizeof(frame_buffers));
+    fb->front = 0;
+    fb->ready = 1;
+    fb->back  = 2;
+    return fb;
+}
+
+static none frame_buffers_free(frame_buffers* fb) {
+    if (!fb) return;
+    for (i32 i = 0; i < 3; i++) {
+        frame_release(&fb->slot[i]);
+        mem_free(fb->slot[i].ops);
+        mem_free(fb->slot[i].refs);
+        mem_free(fb->slot[i].damage);
+    }
+    mem_free(fb);
+}
+
+/// latest published frame_snapshot; lock-free, for one rendering thread.  the snapshot stays
+/// intact until the next call to front.  publishing starts with the first call (or with start)
+handle composer_front(composer ux) {
+    frame_buffers* fb = ux->frames;
+    if (!fb)
+        fb = ux->frames = frame_buffers_new();
+    if (__atomic_load_n(&fb->ready, __ATOMIC_ACQUIRE) & FRAME_FRESH) {
+        u32 prev  = __atomic_exchange_n(&fb->ready, (u32)fb->front, __ATOMIC_ACQ_REL);
+        fb->front = prev & 3;
+    }
+    return &fb->slot[fb->front];
+}
+
+/// releases the side state of the tree and the composer's own tables
+/// with ION_LEAK_CHECK set in the environment, prints the accounting report and any leftovers
+none composer_stop(composer ux);
+
+none composer_dealloc(composer ux) {
+    composer_stop(ux);
+    if (ux->root) {
+        if (ux->slots)
+            slots_release(ux->slots, ux->root);
+        draw_release(composer_runs(ux), null, ux->root);
+        pool_release(ux->root);
+    }
+    task_queue_free(ux->executor);
+    frame_buffers_free(ux->frames);
+    ux->executor = null;
+    ux->frames   = null;
+    if (ux->slots) slots_free(ux->slots);
+    if (ux->draw_ops)  draw_destroy(ux->draw_ops);
+    if (ux->draw_prev) draw_destroy(ux->draw_prev);
+    draw_drain(ux->run_pool);
+    style_avail_free(ux->root_styles);
+    ux->root_styles = null;
+    mem_free(ux->damage_set);
+    mem_free(ux->prof);
+    ux->slots      = null;
+    ux->draw_ops   = null;
+    ux->draw_prev  = null;
+    ux->run_pool   = null;
+    ux->damage_set = null;
+    ux->prof       = null;
+    if (getenv("ION_LEAK_CHECK")) {
+        print("%o", ion_mem_report());
+        if (!ion_mem_check())
+            print("ion: composer state outlived its composer (see composer_transient, elements, transitions)");
+    }
 }
 
-void composer_update_all(composer ux, map render) {
+/// returns the rects that need repainting this frame (empty when nothing visible changed)
+/// transition references point into entries of the previous style state; a new entry can be
+/// allocated at the same address, so forget them and let apply_style retarget from the current value
+static none transitions_unreference(ion n) {
+    sym_map* tr = n->transitions;
+    if (tr)
+        for (i32 i = 0; i < tr->alloc; i++)
+            if (tr->pairs[i].key)
+                ((style_transition)tr->pairs[i].value)->reference = null;
+    pairs(n->elements, i)
+        transitions_unreference(i->value);
+}
+
+array composer_update_all(composer ux, map render) {
+    tick(ux);
+    prof_frame(ux);
+    task_collect(ux);
+    if (ux->traces)
+        clear(ux->traces); /// traces describe the last update only
     ux->restyle = false;
     if (!ux->root) {
          ux->root        = hold(element(id, string("root")));
-         A info = head(ux->style->css_path);
-         ux->root_styles = hold(compute(ux->style, ux->root));
+         ref(ux->root); /// counted like any mounted element; pool_release uncounts it
+         mem_object(mem_elements, isa(ux->root), 1);
          ux->restyle = true;
     }
-    if (!ux->restyle) ux->restyle = check_reload(ux->style);
+    prof_begin(reload);
+    adopt(ux->style);        /// a compile finished since the last frame
+    check_reload(ux->style); /// starts one if the file changed
+    prof_end(ux, reload);
+    /// another composer sharing the style may have published the reload.  root_styles lists the
+    /// snapshot's entries unheld: entered before the generation is read, the epoch keeps them for this frame
+    epoch_enter();
+    u64 generation = __atomic_load_n(&ux->style->generation, __ATOMIC_ACQUIRE);
+    if (generation != ux->style_generation || !ux->root_styles) {
+        if (ux->style_generation)
+            transitions_unreference(ux->root);
+        style_avail_free(ux->root_styles); /// its entries may already be freed; not read
+        ux->root_styles      = compute(ux->style, ux->root);
+        ux->style_generation = generation;
+        ux->restyle          = true;
+    }
     if ( ux->restyle) apply_style(ux, ux->root, ux->root_styles, null);
+    epoch_exit();
+    if (!ux->hot_props)
+        ux->hot_filled = false;
+    else if (!ux->hot_filled) {
+        hot_fill(ux, ux->root); /// just enabled: everything already mounted
+        ux->hot_filled = true;
+    } else if (ux->restyle)
+        hot_sync(ux, ux->root); /// the root is styled here, not in update
     
     // then only apply tag-states here
     update(ux, ux->root, render); /// 'reloaded' is checked inside the update
+    if (ux->compositor)
+        animate(ux); /// the app may not touch ions while composing off-thread; step them here
     //ux->style->reloaded = false;
+    if (!ux->bounds) {
+        prof_frame_end(ux);
+        return null;
+    }
+    prof_begin(layout);
+    layout(ux, ux->bounds);
+    prof_end(ux, layout);
+    prof_begin(paint);
+    paint(ux);
+    prof_end(ux, paint);
+    array damage = damage_flush(ux);
+    frame_publish(ux);
+    prof_frame_end(ux);
+    if (ux->on_render)
+        ux->on_render((object)ux, null);
+    return damage;
+}
+
+/// off-thread composition
+/// after start, update_all runs on a composing thread.  the app hands it render maps with submit
+/// (latest wins), input with post and window size with resize; renderers read composer_front.
+/// event handlers and awaited task results are seen on the composing thread.  the app thread must
+/// not touch mounted ions while it runs; stop joins it and returns to direct update_all.
+/// each frame also animates; while transitions run, it recomposes every COMPOSE_INTERVAL unprompted
+#define COMPOSE_INTERVAL 16666667ll
+
+typedef struct compositor {
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;
+    map             render;     /// submitted, not yet composed
+    map             last;       /// recomposed after input
+    rect            bounds;     /// resize not yet applied
+    event*          events;
+    i32             event_count, event_alloc;
+    bool            stop;
+} compositor;
+
+static void* compositor_main(void* arg) {
+    composer    ux = arg;
+    compositor* c  = ux->compositor;
+    for (;;) {
+        pthread_mutex_lock(&c->lock);
+        bool            timed = ux->animating > 0 && c->last;
+        struct timespec due;
+        if (timed) {
+            i64 step = ux->frame_step > 0 ? ux->frame_step : COMPOSE_INTERVAL;
+            clock_gettime(CLOCK_REALTIME, &due); /// the condition's default clock
+            i64 ns = due.tv_nsec + step;
+            due.tv_sec  += ns / 1000000000ll;
+            due.tv_nsec  = ns % 1000000000ll;
+        }
+        while (!c->render && !c->event_count && !c->bounds && !c->stop) {
+            if (!timed)
+                pthread_cond_wait(&c->wake, &c->lock);
+            else if (pthread_cond_timedwait(&c->wake, &c->lock, &due) == ETIMEDOUT)
+                break; /// next animation frame
+        }
+        if (c->stop) {
+            pthread_mutex_unlock(&c->lock);
+            return null;
+        }
+        map    render = c->render;
+        rect   bounds = c->bounds;
+        i32    n      = c->event_count;
+        event* events = c->events;
+        c->render      = null;
+        c->bounds      = null;
+        c->events      = null;
+        c->event_count = 0;
+        c->event_alloc = 0;
+        pthread_mutex_unlock(&c->lock);
+
+        if (bounds) {
+            if (ux->bounds) drop(ux->bounds);
+            ux->bounds = bounds; /// held by resize
+        }
+        for (i32 i = 0; i < n; i++) {
+            if (ux->root)
+                dispatch(ux, events[i], (element)ux->root);
+            drop(events[i]);
+        }
+        mem_free(events);
+        if (render) {
+            if (c->last) drop(c->last);
+            c->last = render; /// held by submit
+        }
+        if (c->last)
+            update_all(ux, c->last);
+    }
+}
+
+none composer_start(composer ux) {
+    if (ux->compositor)
+        return;
+    if (!ux->frames)
+        ux->frames = frame_buffers_new();
+    compositor* c = mem_calloc(mem_transient, 1, sizeof(compositor));
+    pthread_mutex_init(&c->lock, null);
+    pthread_cond_init(&c->wake, null);
+    ux->compositor = c;
+    style_handoff(ux->style, pthread_self()); /// the composing thread adopts reloads from now on
+    if (pthread_create(&c->thread, null, compositor_main, ux) != 0) {
+        pthread_mutex_destroy(&c->lock);
+        pthread_cond_destroy(&c->wake);
+        mem_free(c);
+        ux->compositor = null; /// stays in direct mode
+    }
+}
+
+none composer_stop(composer ux) {
+    compositor* c = ux->compositor;
+    if (!c) return;
+    pthread_mutex_lock(&c->lock);
+    c->stop = true;
+    pthread_cond_signal(&c->wake);
+    pthread_mutex_unlock(&c->lock);
+    pthread_join(c->thread, null);
+    style_handoff(ux->style, c->thread);
+    if (c->render) drop(c->render);
+    if (c->last)   drop(c->last);
+    if (c->bounds) drop(c->bounds);
+    for (i32 i = 0; i < c->event_count; i++)
+        drop(c->events[i]);
+    mem_free(c->events);
+    pthread_mutex_destroy(&c->lock);
+    pthread_cond_destroy(&c->wake);
+    mem_free(c);
+    ux->compositor = null;
+}
+
+/// direct mode composes now; started, the composing thread takes the latest map
+none composer_submit(composer ux, map render) {
+    compositor* c = ux->compositor;
+    if (!c) {
+        update_all(ux, render);
+        return;
+    }
+    pthread_mutex_lock(&c->lock);
+    if (c->render) drop(c->render); /// superseded before it was composed
+    c->render = hold(render);
+    pthread_cond_signal(&c->wake);
+    pthread_mutex_unlock(&c->lock);
+}
+
+/// input is dispatched from the root in posting order, ahead of the next composition
+none composer_post(composer ux, event ev) {
+    compositor* c = ux->compositor;
+    if (!c) {
+        if (ux->root)
+            dispatch(ux, ev, (element)ux->root);
+        return;
+    }
+    pthread_mutex_lock(&c->lock);
+    if (c->event_count == c->event_alloc) {
+        c->event_alloc = c->event_alloc ? c->event_alloc << 1 : 16;
+        c->events = mem_realloc(mem_transient, c->events, sizeof(event) * c->event_alloc);
+    }
+    c->events[c->event_count++] = hold(ev);
+    pthread_cond_signal(&c->wake);
+    pthread_mutex_unlock(&c->lock);
+}
+
+none composer_resize(composer ux, rect bounds) {
+    compositor* c = ux->compositor;
+    if (!c) {
+        if (ux->bounds) drop(ux->bounds);
+        ux->bounds = hold(bounds);
+        return;
+    }
+    pthread_mutex_lock(&c->lock);
+    if (c->bounds) drop(c->bounds);
+    c->bounds = hold(bounds);
+    pthread_cond_signal(&c->wake);
+    pthread_mutex_unlock(&c->lock);
 }
 
 define_class(tcoord, unit, Duration)
@@ -1357,6 +5097,7 @@ define_enum(Duration)
 define_enum(xalign)
 define_enum(yalign)
 define_enum(Canvas)
+define_enum(draw_kind)
 define_enum(Button)
 define_typed_enum(Fill, f32)
 
@@ -1368,6 +5109,7 @@ define_struct(keyboard_state,    i32)
 define_class(line_info,         A)
 define_class(text_sel,          A)
 define_class(text,              A)
+define_class(text_shape,        A)
 define_class(composer,          A)
 define_class(arg,               A)
 define_class(style,             A)
@@ -1376,6 +5118,9 @@ define_class(style_entry,       A)
 define_class(style_qualifier,   A)
 define_class(style_transition,  A)
 define_class(style_selection,   A)
+define_class(style_candidate,   A)
+define_class(style_trace,       A)
+define_class(ion_task,          A)
 
 define_class(ion,               A)
 define_class(event,             A)
@@ -1383,5 +5128,6 @@ define_class(event,             A)
 define_class(element,           ion)
 define_class(button,            element)
 define_class(pane,              element)
+define_class(list_view,         element)
 // future plan (actual app server concept on 'system')
 // any classes using ion will have mmap members, as they must be publically accessible on the system
@@ -74,8 +74,8 @@ struct TextSel {
 static str root_app_class;
 
 
-/// to debug style, place conditional breakpoint on member->s_key == "your-prop" (used in a style block) and n->data->id == "id-you-are-debugging"
-/// hopefully we dont have to do this anymore.  its simple and it works.  we may be doing our own style across service component and elemental component but having one system for all is preferred,
+/// to debug style in the C composer (lib/ion.c), build with ION_STYLE_TRACE and set trace_style on it;
+/// this legacy implementation is not built.  we may be doing our own style across service component and elemental component but having one system for all is preferred,
 /// and brings a sense of orthogonality to the react-like pattern, adds type-based contextual grabs and field lookups with prop accessors
 style::entry *style::impl::best_match(node *n, prop *member, Array<style::entry*> &entries) {
     Array<style::block*> &blocks = members.get<Array<style::block*>>(*member->s_key); /// instance function when loading and updating style, managed map of [style::block*]